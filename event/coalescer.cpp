@@ -0,0 +1,90 @@
+#include "coalescer.h"
+
+static uint32_t distance_squared(const event &a, const event &b) {
+  int dx = static_cast<int>(a.x) - b.x;
+  int dy = static_cast<int>(a.y) - b.y;
+  return dx * dx + dy * dy;
+}
+
+touch_coalescer::touch_coalescer(const config &c) : m_config(c) {}
+
+void touch_coalescer::set_config(const config &c) { m_config = c; }
+
+touch_coalescer::config touch_coalescer::get_config() const {
+  return m_config;
+}
+
+void touch_coalescer::push(const event &ev) {
+  switch (ev.type) {
+  case event::type_t::none:
+    return;
+
+  case event::type_t::unlock:
+    // The controller has been reset, no touch survives that.
+    m_open_drags.clear();
+    m_path_anchors.clear();
+    m_pending.emplace_back(ev);
+    return;
+
+  case event::type_t::touch:
+    m_open_drags.erase(ev.touch_id);
+    m_path_anchors[ev.touch_id] = ev;
+    m_pending.emplace_back(ev);
+    return;
+
+  case event::type_t::release:
+    m_open_drags.erase(ev.touch_id);
+    m_path_anchors.erase(ev.touch_id);
+    m_pending.emplace_back(ev);
+    return;
+
+  case event::type_t::drag:
+    break;
+  }
+
+  auto open_drag = m_open_drags.find(ev.touch_id);
+  if (open_drag == m_open_drags.end()) {
+    m_open_drags[ev.touch_id] = m_pending.size();
+    m_pending.emplace_back(ev);
+
+    if (!m_path_anchors.contains(ev.touch_id))
+      m_path_anchors[ev.touch_id] = ev;
+    return;
+  }
+
+  auto &tail = m_pending[open_drag->second];
+
+  if (m_config.keep_path) {
+    auto &anchor = m_path_anchors[ev.touch_id];
+    uint32_t min_distance = m_config.path_min_distance;
+
+    if (distance_squared(tail, anchor) >= min_distance * min_distance) {
+      // The tail went far enough: keep it as a path point and start a new
+      // tail. Note that the tail reference is invalidated by emplace_back.
+      anchor = tail;
+      open_drag->second = m_pending.size();
+      m_pending.emplace_back(ev);
+      return;
+    }
+  }
+
+  tail = ev;
+  ++m_merged;
+}
+
+void touch_coalescer::push(const std::vector<event> &events) {
+  for (const auto &ev : events)
+    push(ev);
+}
+
+bool touch_coalescer::empty() const { return m_pending.empty(); }
+
+std::vector<event> touch_coalescer::take() {
+  std::vector<event> result;
+  result.swap(m_pending);
+  m_open_drags.clear();
+
+  return result;
+}
+
+size_t touch_coalescer::merged() const { return m_merged; }
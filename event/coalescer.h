@@ -0,0 +1,68 @@
+#pragma once
+
+#include "touch.h"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Collapses bursts of touch events that piled up while the consumer was busy
+ * (e.g. while the E-Ink display was refreshing).
+ *
+ * Consecutive drag events of the same touch are merged into the latest
+ * sample, so the amount of work needed to dispatch a burst is bounded by the
+ * number of distinct touches rather than by the length of the burst. Touch,
+ * release and unlock events are never dropped or reordered relative to the
+ * drags of the same touch.
+ */
+class touch_coalescer {
+public:
+  struct config {
+    /**
+     * Keep a decimated drag path instead of the latest sample only. Useful
+     * for inking, where intermediate points matter.
+     */
+    bool keep_path = false;
+
+    /**
+     * Minimal distance (in touch panel units) between two kept path points.
+     * Only meaningful if keep_path is set.
+     */
+    uint16_t path_min_distance = 8;
+  };
+
+private:
+  config m_config;
+  std::vector<event> m_pending;
+
+  // Index of the last drag of a touch in m_pending that still may be
+  // overwritten by a newer sample.
+  std::unordered_map<uint8_t, size_t> m_open_drags;
+
+  // The last sample of a touch that has been kept as a path point.
+  std::unordered_map<uint8_t, event> m_path_anchors;
+
+  size_t m_merged = 0;
+
+public:
+  touch_coalescer() = default;
+  touch_coalescer(const config &c);
+
+  void set_config(const config &c);
+  config get_config() const;
+
+  void push(const event &ev);
+  void push(const std::vector<event> &events);
+
+  bool empty() const;
+
+  /**
+   * Get all the pending events in order and reset the coalescer.
+   */
+  std::vector<event> take();
+
+  /**
+   * Total count of events that were merged into the newer ones.
+   */
+  size_t merged() const;
+};
@@ -0,0 +1,171 @@
+#include "event_loop.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <sstream>
+#include <stdexcept>
+
+static const int max_events_per_wait = 16;
+
+static void throw_errno(const char *what) {
+  std::stringstream error;
+  error << "event_loop: " << what << " failed with error: " << strerror(errno);
+  throw std::runtime_error(error.str());
+}
+
+static timespec to_timespec(std::chrono::nanoseconds duration) {
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+  timespec result{};
+  result.tv_sec = seconds.count();
+  result.tv_nsec = (duration - seconds).count();
+  return result;
+}
+
+event_loop::event_loop() {
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll_fd < 0)
+    throw_errno("epoll_create1");
+
+  m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_wakeup_fd < 0)
+    throw_errno("eventfd");
+
+  watch(m_wakeup_fd, [this]() {
+    uint64_t counter = 0;
+    ::read(m_wakeup_fd, &counter, sizeof(counter));
+    run_posted();
+  });
+}
+
+event_loop::~event_loop() {
+  for (auto timer : m_timers)
+    ::close(timer);
+
+  ::close(m_wakeup_fd);
+  ::close(m_epoll_fd);
+}
+
+void event_loop::watch(int fd, callback cb) {
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    throw_errno("epoll_ctl");
+
+  m_callbacks[fd] = std::move(cb);
+}
+
+void event_loop::run_posted() {
+  std::vector<callback> posted;
+  {
+    std::lock_guard lock(m_posted_mutex);
+    posted.swap(m_posted);
+  }
+
+  for (auto &cb : posted)
+    cb();
+}
+
+void event_loop::add_fd(int fd, callback cb) { watch(fd, std::move(cb)); }
+
+void event_loop::remove_fd(int fd) {
+  if (!m_callbacks.erase(fd))
+    return;
+
+  epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+event_loop::timer_id event_loop::add_timer(std::chrono::nanoseconds delay,
+                                           std::chrono::nanoseconds interval,
+                                           callback cb) {
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (fd < 0)
+    throw_errno("timerfd_create");
+
+  watch(fd, [fd, cb = std::move(cb)]() {
+    uint64_t expirations = 0;
+    if (::read(fd, &expirations, sizeof(expirations)) > 0)
+      cb();
+  });
+
+  m_timers.insert(fd);
+  set_timer(fd, delay, interval);
+
+  return fd;
+}
+
+void event_loop::set_timer(timer_id id, std::chrono::nanoseconds delay,
+                           std::chrono::nanoseconds interval) {
+  itimerspec spec{};
+  spec.it_value = to_timespec(delay);
+  spec.it_interval = to_timespec(interval);
+
+  if (timerfd_settime(id, 0, &spec, nullptr) < 0)
+    throw_errno("timerfd_settime");
+}
+
+void event_loop::remove_timer(timer_id id) {
+  if (!m_timers.erase(id))
+    return;
+
+  remove_fd(id);
+  ::close(id);
+}
+
+void event_loop::post(callback cb) {
+  {
+    std::lock_guard lock(m_posted_mutex);
+    m_posted.emplace_back(std::move(cb));
+  }
+
+  wakeup();
+}
+
+void event_loop::wakeup() {
+  uint64_t one = 1;
+  ::write(m_wakeup_fd, &one, sizeof(one));
+}
+
+bool event_loop::run_once(std::chrono::milliseconds timeout) {
+  epoll_event events[max_events_per_wait];
+
+  int ready = epoll_wait(m_epoll_fd, events, max_events_per_wait,
+                         timeout.count() < 0 ? -1 : timeout.count());
+  if (ready < 0) {
+    if (errno == EINTR)
+      return true;
+
+    throw_errno("epoll_wait");
+  }
+
+  for (int i = 0; i < ready; ++i) {
+    // A callback may remove any source, including its own one; so look it
+    // up every time and call a copy of it.
+    auto found = m_callbacks.find(events[i].data.fd);
+    if (found == m_callbacks.end())
+      continue;
+
+    auto cb = found->second;
+    cb();
+  }
+
+  return ready > 0;
+}
+
+void event_loop::run() {
+  m_running = true;
+
+  while (m_running)
+    run_once();
+}
+
+void event_loop::stop() {
+  m_running = false;
+  wakeup();
+}
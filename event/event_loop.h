@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * A single threaded epoll based event loop.
+ *
+ * Waits for any number of file descriptors (e.g. gpiod line event fds of the
+ * touch interrupt and the display BUSY line), timers (timerfd) and
+ * cross-thread wakeups (eventfd) at once, and calls the callback of every
+ * source which became ready. It never wakes up unless a source is ready.
+ *
+ * Everything but event_loop::post, event_loop::wakeup and event_loop::stop
+ * must be called from the thread running the loop.
+ */
+class event_loop {
+public:
+  using callback = std::function<void()>;
+  using timer_id = int;
+
+  static constexpr std::chrono::milliseconds forever{-1};
+
+private:
+  int m_epoll_fd = -1;
+  int m_wakeup_fd = -1;
+  std::atomic<bool> m_running = false;
+
+  std::unordered_map<int, callback> m_callbacks;
+  std::unordered_set<timer_id> m_timers;
+
+  std::mutex m_posted_mutex;
+  std::vector<callback> m_posted;
+
+  void watch(int fd, callback cb);
+  void run_posted();
+
+public:
+  event_loop();
+  ~event_loop();
+
+  event_loop(const event_loop &) = delete;
+  event_loop &operator=(const event_loop &) = delete;
+
+  /**
+   * Call the callback every time the file descriptor becomes readable.
+   * The callback is responsible for consuming whatever made it readable.
+   */
+  void add_fd(int fd, callback cb);
+  void remove_fd(int fd);
+
+  /**
+   * Create a timer.
+   * @param delay time until the first expiration
+   * @param interval repeat interval, or zero for a one-shot timer
+   * @param cb callback to call on expiration
+   * @return id of the timer
+   */
+  timer_id add_timer(std::chrono::nanoseconds delay,
+                     std::chrono::nanoseconds interval, callback cb);
+
+  /**
+   * Rearm an existing timer; a zero delay disarms it.
+   */
+  void set_timer(timer_id id, std::chrono::nanoseconds delay,
+                 std::chrono::nanoseconds interval = {});
+  void remove_timer(timer_id id);
+
+  /**
+   * Queue a callback to be called from the loop thread. Thread safe.
+   */
+  void post(callback cb);
+
+  /**
+   * Interrupt the current (or the next) wait. Thread safe.
+   */
+  void wakeup();
+
+  /**
+   * Wait for sources and call their callbacks once.
+   * @param timeout how long to wait; negative to wait forever
+   * @return false if the timeout has expired without any source being ready
+   */
+  bool run_once(std::chrono::milliseconds timeout = forever);
+
+  /**
+   * Run until event_loop::stop is called.
+   */
+  void run();
+
+  /**
+   * Make event_loop::run return. Thread safe.
+   */
+  void stop();
+};
@@ -0,0 +1,143 @@
+#include "filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+// Drags received within the same batch share the timestamp; pretend they are
+// at least a millisecond apart to keep the filter math sane.
+static const double min_time_step = 0.001;
+
+static double smoothing_factor(double cutoff, double dt) {
+  double tau = 1.0 / (2 * std::numbers::pi * cutoff);
+  return 1.0 / (1.0 + tau / dt);
+}
+
+static uint16_t to_coordinate(double value) {
+  return static_cast<uint16_t>(std::clamp(std::lround(value), 0L, 0xffffL));
+}
+
+size_t touch_filter::statistics::suppressed() const {
+  return suppressed_dead_zone + suppressed_size_only;
+}
+
+double touch_filter::low_pass::apply(double input, double alpha) {
+  if (!initialized) {
+    initialized = true;
+    value = input;
+  } else
+    value = alpha * input + (1.0 - alpha) * value;
+
+  return value;
+}
+
+double touch_filter::axis::apply(double input, double dt, const config &c) {
+  double raw_speed = position.initialized ? (input - position.value) / dt : 0;
+  double filtered_speed =
+      speed.apply(raw_speed, smoothing_factor(c.derivative_cutoff, dt));
+  double cutoff = c.min_cutoff + c.beta * std::abs(filtered_speed);
+
+  return position.apply(input, smoothing_factor(cutoff, dt));
+}
+
+touch_filter::touch_filter(const config &c) : m_config(c) {}
+
+void touch_filter::set_config(const config &c) { m_config = c; }
+
+touch_filter::config touch_filter::get_config() const { return m_config; }
+
+touch_filter::statistics touch_filter::get_statistics() const {
+  return m_statistics;
+}
+
+void touch_filter::reset_statistics() { m_statistics = {}; }
+
+bool touch_filter::filter(event &ev, clock::time_point timestamp) {
+  switch (ev.type) {
+  case event::type_t::none:
+    return false;
+
+  case event::type_t::unlock:
+    m_tracks.clear();
+    ++m_statistics.passed;
+    return true;
+
+  case event::type_t::release: {
+    auto t = m_tracks.find(ev.touch_id);
+    if (t != m_tracks.end()) {
+      ev.x = t->second.emitted.x;
+      ev.y = t->second.emitted.y;
+      m_tracks.erase(t);
+    }
+
+    ++m_statistics.passed;
+    return true;
+  }
+
+  case event::type_t::touch:
+  case event::type_t::drag:
+    break;
+  }
+
+  auto t = m_tracks.find(ev.touch_id);
+  if (ev.type == event::type_t::touch || t == m_tracks.end()) {
+    // Either a new touch, or a drag of a touch which has not been seen yet.
+    auto &new_track = m_tracks[ev.touch_id];
+    new_track = {};
+    new_track.timestamp = timestamp;
+    new_track.x.position.apply(ev.x, 1.0);
+    new_track.y.position.apply(ev.y, 1.0);
+    new_track.emitted = ev;
+
+    ++m_statistics.passed;
+    return true;
+  }
+
+  auto &current = t->second;
+  double dt = std::chrono::duration<double>(timestamp - current.timestamp)
+                  .count();
+  dt = std::max(dt, min_time_step);
+  current.timestamp = timestamp;
+
+  event candidate = ev;
+  if (m_config.smoothing) {
+    candidate.x = to_coordinate(current.x.apply(ev.x, dt, m_config));
+    candidate.y = to_coordinate(current.y.apply(ev.y, dt, m_config));
+  }
+
+  const auto &emitted = current.emitted;
+  int moved_x = std::abs(static_cast<int>(candidate.x) - emitted.x);
+  int moved_y = std::abs(static_cast<int>(candidate.y) - emitted.y);
+
+  if (!moved_x && !moved_y) {
+    if (candidate.size == emitted.size) {
+      ++m_statistics.suppressed_dead_zone;
+      return false;
+    }
+
+    if (m_config.suppress_size_only) {
+      ++m_statistics.suppressed_size_only;
+      return false;
+    }
+  } else if (std::max(moved_x, moved_y) < m_config.dead_zone) {
+    ++m_statistics.suppressed_dead_zone;
+    return false;
+  }
+
+  ev = candidate;
+  current.emitted = candidate;
+  ++m_statistics.passed;
+  return true;
+}
+
+std::vector<event> touch_filter::filter(const std::vector<event> &events,
+                                        clock::time_point timestamp) {
+  std::vector<event> result;
+  result.reserve(events.size());
+
+  for (auto ev : events)
+    if (filter(ev, timestamp))
+      result.emplace_back(ev);
+
+  return result;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "touch.h"
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Suppresses drag events which are caused by jitter of a stationary finger.
+ *
+ * Every drag is passed through the adaptive low-pass "1 Euro filter" (Casiez,
+ * Roussel, Vogel, 2012): slow motion is smoothed heavily, fast motion is
+ * passed through with little lag. A smoothed drag is then dropped if it moved
+ * less than the dead zone away from the last emitted position of that touch,
+ * or if only the touch size changed.
+ *
+ * Touch, release and unlock events always pass. Release events are moved to
+ * the last emitted position, so that a release is reported exactly where the
+ * consumer saw the touch for the last time.
+ */
+class touch_filter {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct config {
+    /**
+     * Drags closer than that (in touch panel units, on any axis) to the last
+     * emitted position are suppressed. 0 disables the dead zone.
+     */
+    uint16_t dead_zone = 2;
+
+    /**
+     * Suppress drags which differ from the last emitted event by size only.
+     */
+    bool suppress_size_only = true;
+
+    /**
+     * Enable the adaptive low-pass filter.
+     */
+    bool smoothing = true;
+
+    /**
+     * Cutoff frequency (Hz) for a stationary touch. Lower values mean less
+     * jitter, but more lag at low speeds.
+     */
+    double min_cutoff = 1.0;
+
+    /**
+     * Speed coefficient. Higher values mean less lag at high speeds.
+     */
+    double beta = 0.05;
+
+    /**
+     * Cutoff frequency (Hz) used to smooth the speed estimation.
+     */
+    double derivative_cutoff = 1.0;
+  };
+
+  struct statistics {
+    size_t passed = 0;
+    size_t suppressed_dead_zone = 0;
+    size_t suppressed_size_only = 0;
+
+    size_t suppressed() const;
+  };
+
+private:
+  struct low_pass {
+    bool initialized = false;
+    double value = 0;
+
+    double apply(double input, double alpha);
+  };
+
+  struct axis {
+    low_pass position;
+    low_pass speed;
+
+    double apply(double input, double dt, const config &c);
+  };
+
+  struct track {
+    clock::time_point timestamp;
+    axis x;
+    axis y;
+    event emitted;
+  };
+
+  config m_config;
+  statistics m_statistics;
+  std::unordered_map<uint8_t, track> m_tracks;
+
+public:
+  touch_filter() = default;
+  touch_filter(const config &c);
+
+  void set_config(const config &c);
+  config get_config() const;
+
+  statistics get_statistics() const;
+  void reset_statistics();
+
+  /**
+   * Filter a single event.
+   * @param ev event to filter, coordinates of it may be updated
+   * @param timestamp moment of time the event has been received
+   * @return false if the event should be dropped
+   */
+  bool filter(event &ev, clock::time_point timestamp = clock::now());
+
+  /**
+   * Filter a batch of events that has been received at once.
+   */
+  std::vector<event> filter(const std::vector<event> &events,
+                            clock::time_point timestamp = clock::now());
+};
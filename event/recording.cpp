@@ -0,0 +1,168 @@
+#include "recording.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <thread>
+
+using namespace bytes;
+
+namespace recording {
+
+static const vect magic = {'E', 'T', 'R', 'C'};
+static const uint16_t format_version = 1;
+static const size_t event_size = 8;
+
+static void append(vect &output, const vect &data) {
+  output.insert(output.end(), data.begin(), data.end());
+}
+
+recorder::recorder(const fs::path &p)
+    : m_output(p, std::ios::binary | std::ios::trunc), m_last(clock::now()) {
+  if (!m_output.good()) {
+    std::stringstream error;
+    error << "Failed to open file: " << p;
+    throw std::runtime_error(error.str());
+  }
+
+  vect header = magic;
+  append(header, le(format_version));
+  m_output.write(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+void recorder::write_frame_header(frame::kind_t kind, clock::time_point t,
+                                  size_t count) {
+  if (count > 0xff)
+    throw std::length_error("Too many items in a single recording frame");
+
+  auto delta = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::max(t, m_last) - m_last);
+  m_last = std::max(t, m_last);
+
+  // Don't let long gaps wrap around to short ones.
+  const auto gap = std::min<int64_t>(delta.count(), UINT32_MAX);
+
+  vect header;
+  append(header, le(static_cast<uint8_t>(kind)));
+  append(header, le(static_cast<uint32_t>(gap)));
+  append(header, le(static_cast<uint8_t>(count)));
+  m_output.write(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+void recorder::record_report(const vect &raw, clock::time_point t) {
+  write_frame_header(frame::kind_t::raw_report, t, raw.size());
+  m_output.write(reinterpret_cast<const char *>(raw.data()), raw.size());
+}
+
+void recorder::record_events(const std::vector<event> &events,
+                             clock::time_point t) {
+  write_frame_header(frame::kind_t::events, t, events.size());
+
+  vect payload;
+  payload.reserve(events.size() * event_size);
+  for (const auto &ev : events) {
+    append(payload, le(static_cast<uint8_t>(ev.type)));
+    append(payload, le(ev.touch_id));
+    append(payload, le(ev.x));
+    append(payload, le(ev.y));
+    append(payload, le(ev.size));
+  }
+
+  m_output.write(reinterpret_cast<const char *>(payload.data()),
+                 payload.size());
+}
+
+void recorder::flush() { m_output.flush(); }
+
+player::player(const fs::path &p) {
+  std::ifstream input(p, std::ios::binary);
+  if (!input.good()) {
+    std::stringstream error;
+    error << "Failed to open file: " << p;
+    throw std::runtime_error(error.str());
+  }
+
+  vect data((std::istreambuf_iterator<char>(input)),
+            std::istreambuf_iterator<char>());
+  buffer parser(data, endian::little);
+
+  vect file_magic(magic.size());
+  uint16_t version = 0;
+  for (auto &b : file_magic)
+    parser >> b;
+  parser >> version;
+
+  if (file_magic != magic)
+    throw std::runtime_error("Not a touch session recording");
+
+  if (version != format_version) {
+    std::stringstream error;
+    error << "Unsupported touch session recording version " << version;
+    throw std::runtime_error(error.str());
+  }
+
+  clock::duration timestamp{};
+  while (parser.tell() < data.size()) {
+    frame f;
+    uint8_t kind = 0;
+    uint32_t delta = 0;
+    uint8_t count = 0;
+    parser >> kind >> delta >> count;
+
+    timestamp += std::chrono::microseconds(delta);
+    f.timestamp = timestamp;
+    f.kind = static_cast<frame::kind_t>(kind);
+
+    switch (f.kind) {
+    case frame::kind_t::raw_report:
+      f.raw_report.resize(count);
+      for (auto &b : f.raw_report)
+        parser >> b;
+      break;
+
+    case frame::kind_t::events:
+      f.events.resize(count);
+      for (auto &ev : f.events) {
+        uint8_t type = 0;
+        parser >> type >> ev.touch_id >> ev.x >> ev.y >> ev.size;
+        ev.type = static_cast<event::type_t>(type);
+      }
+      break;
+
+    default:
+      throw std::runtime_error("Corrupted touch session recording");
+    }
+
+    m_frames.emplace_back(std::move(f));
+  }
+}
+
+const std::vector<frame> &player::frames() const { return m_frames; }
+
+size_t player::event_count() const {
+  size_t count = 0;
+  for (const auto &f : m_frames)
+    count += f.events.size();
+
+  return count;
+}
+
+clock::duration player::duration() const {
+  return m_frames.empty() ? clock::duration{} : m_frames.back().timestamp;
+}
+
+void player::play(const sink &s, pace_t pace) const {
+  const auto start = clock::now();
+
+  for (const auto &f : m_frames) {
+    if (f.kind != frame::kind_t::events)
+      continue;
+
+    if (pace == pace_t::original)
+      std::this_thread::sleep_until(start + f.timestamp);
+
+    s(f.events);
+  }
+}
+
+} // namespace recording
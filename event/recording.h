@@ -0,0 +1,87 @@
+#pragma once
+
+#include "touch.h"
+
+#include <byte_util.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+/**
+ * Binary touch session format, all values are little endian:
+ *
+ * header: "ETRC" magic, uint16 format version
+ * frame:  uint8 kind, uint32 microseconds since the previous frame,
+ *         uint8 payload item count, payload
+ *
+ * Gaps between frames longer than the uint32 microseconds can hold (about
+ * 71 minutes) are recorded as that maximum.
+ *
+ * The payload of a raw report frame is the bytes read from the touch
+ * controller; the payload of an events frame is a list of decoded events,
+ * 8 bytes each: type, touch id, x, y, size.
+ */
+namespace recording {
+
+using clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+struct frame {
+  enum class kind_t : uint8_t { raw_report = 1, events = 2 };
+
+  kind_t kind = kind_t::events;
+  clock::duration timestamp{}; // since the beginning of the session
+  bytes::vect raw_report;
+  std::vector<event> events;
+};
+
+class recorder {
+  std::ofstream m_output;
+  clock::time_point m_last;
+
+  void write_frame_header(frame::kind_t kind, clock::time_point t,
+                          size_t count);
+
+public:
+  recorder(const fs::path &p);
+
+  void record_report(const bytes::vect &raw,
+                     clock::time_point t = clock::now());
+  void record_events(const std::vector<event> &events,
+                     clock::time_point t = clock::now());
+  void flush();
+};
+
+class player {
+public:
+  enum class pace_t { original, fast };
+
+  using sink = std::function<void(const std::vector<event> &)>;
+
+private:
+  std::vector<frame> m_frames;
+
+public:
+  /**
+   * Load the whole recording into the memory, so that file I/O doesn't
+   * affect the replay timing.
+   */
+  player(const fs::path &p);
+
+  const std::vector<frame> &frames() const;
+  size_t event_count() const;
+  clock::duration duration() const;
+
+  /**
+   * Feed every recorded events frame into the sink.
+   * @param s a sink to feed events to
+   * @param pace either reproduce the original timing, or go as fast as
+   * possible
+   */
+  void play(const sink &s, pace_t pace = pace_t::original) const;
+};
+
+} // namespace recording
@@ -0,0 +1,169 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <vector>
+
+// Weight of the newest sample in the refresh duration estimate.
+static const double refresh_estimate_weight = 0.25;
+
+frame_scheduler::frame_scheduler(event_loop &loop, callback present)
+    : frame_scheduler(loop, std::move(present), config()) {}
+
+frame_scheduler::frame_scheduler(event_loop &loop, callback present,
+                                 const config &c)
+    : m_loop(loop), m_present(std::move(present)), m_config(c) {
+  m_wakeup_timer = m_loop.add_timer({}, {}, [this]() { tick(); });
+}
+
+frame_scheduler::~frame_scheduler() { m_loop.remove_timer(m_wakeup_timer); }
+
+frame_scheduler::clock::time_point
+frame_scheduler::next_present_allowed() const {
+  return m_last_present + min_present_interval();
+}
+
+void frame_scheduler::tick() {
+  m_in_tick = true;
+  auto now = clock::now();
+
+  // Callbacks may add or cancel timers, so collect the due ones first.
+  std::vector<id> due;
+  for (const auto &[i, t] : m_timers)
+    if (t.due <= now + m_config.slack)
+      due.emplace_back(i);
+
+  for (auto i : due) {
+    auto t = m_timers.find(i);
+    if (t == m_timers.end())
+      continue;
+
+    auto cb = t->second.cb;
+    if (t->second.interval == clock::duration::zero())
+      m_timers.erase(t);
+    else
+      t->second.due = std::max(t->second.due + t->second.interval,
+                               now + t->second.interval / 2);
+
+    cb();
+  }
+
+  if (!m_animations.empty() && now >= next_present_allowed()) {
+    std::vector<id> running;
+    for (const auto &[i, a] : m_animations)
+      running.emplace_back(i);
+
+    for (auto i : running) {
+      auto a = m_animations.find(i);
+      if (a == m_animations.end())
+        continue;
+
+      auto elapsed = std::chrono::duration<double>(now - a->second.start);
+      auto duration = std::chrono::duration<double>(a->second.duration);
+      double progress = duration.count() > 0
+                            ? std::min(1.0, elapsed / duration)
+                            : 1.0;
+
+      auto cb = a->second.cb;
+      if (progress >= 1.0)
+        m_animations.erase(a);
+
+      cb(progress);
+    }
+
+    m_dirty = true;
+  }
+
+  if (m_dirty && now >= next_present_allowed()) {
+    m_dirty = false;
+    m_last_present = now;
+    m_present();
+  }
+
+  m_in_tick = false;
+  rearm();
+}
+
+void frame_scheduler::rearm() {
+  if (m_in_tick)
+    return; // tick rearms once it's done
+
+  auto now = clock::now();
+  auto deadline = clock::time_point::max();
+
+  for (const auto &[i, t] : m_timers)
+    deadline = std::min(deadline, t.due);
+
+  if (m_dirty || !m_animations.empty())
+    deadline = std::min(deadline, std::max(now, next_present_allowed()));
+
+  if (deadline == clock::time_point::max()) {
+    m_loop.set_timer(m_wakeup_timer, {}); // nothing to do, disarm
+    return;
+  }
+
+  // Zero delay would disarm the timer
+  auto delay = std::max<clock::duration>(deadline - now,
+                                         std::chrono::nanoseconds(1));
+  m_loop.set_timer(m_wakeup_timer, delay);
+}
+
+frame_scheduler::id
+frame_scheduler::add_timer(std::chrono::nanoseconds interval, callback cb,
+                           bool repeat) {
+  auto i = m_next_id++;
+  m_timers[i] = {clock::now() + interval,
+                 repeat ? interval : clock::duration::zero(), std::move(cb)};
+  rearm();
+  return i;
+}
+
+frame_scheduler::id
+frame_scheduler::add_animation(std::chrono::nanoseconds duration,
+                               animation_callback cb) {
+  auto i = m_next_id++;
+  m_animations[i] = {clock::now(), duration, std::move(cb)};
+  rearm();
+  return i;
+}
+
+void frame_scheduler::cancel(id i) {
+  m_timers.erase(i);
+  m_animations.erase(i);
+  rearm();
+}
+
+void frame_scheduler::request_present() {
+  m_dirty = true;
+
+  if (m_in_tick)
+    return;
+
+  if (clock::now() >= next_present_allowed()) {
+    // Nothing to wait for, present right away.
+    m_dirty = false;
+    m_last_present = clock::now();
+    m_present();
+  }
+
+  rearm();
+}
+
+void frame_scheduler::note_refresh_duration(
+    std::chrono::nanoseconds duration) {
+  if (m_refresh_estimate == clock::duration::zero()) {
+    m_refresh_estimate = duration;
+    return;
+  }
+
+  m_refresh_estimate = std::chrono::duration_cast<clock::duration>(
+      refresh_estimate_weight * duration +
+      (1.0 - refresh_estimate_weight) * m_refresh_estimate);
+}
+
+std::chrono::nanoseconds frame_scheduler::min_present_interval() const {
+  auto measured = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      m_config.refresh_headroom * m_refresh_estimate);
+
+  return std::max<std::chrono::nanoseconds>(m_config.min_present_interval,
+                                            measured);
+}
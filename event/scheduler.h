@@ -0,0 +1,124 @@
+#pragma once
+
+#include "event_loop.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+
+/**
+ * Runs timers and animations on top of an event_loop, and decides when the
+ * UI gets presented on the display.
+ *
+ * An E-Ink panel takes hundreds of milliseconds for a partial refresh, so
+ * presenting every single change is pointless. Instead, callbacks only mark
+ * the UI as changed with frame_scheduler::request_present, and the scheduler
+ * calls the present callback at most once per minimal present interval. The
+ * interval is derived from the measured display refresh durations (see
+ * frame_scheduler::note_refresh_duration).
+ *
+ * Timers which are due within the configured slack from each other are run
+ * together, so that their changes end up in a single present. Animations are
+ * stepped right before a present, i.e. at the rate the panel can deliver.
+ */
+class frame_scheduler {
+public:
+  using clock = std::chrono::steady_clock;
+  using id = unsigned;
+  using callback = std::function<void()>;
+
+  /**
+   * Animation step; progress goes from 0 to 1, and the last step is always
+   * called with exactly 1.
+   */
+  using animation_callback = std::function<void(double progress)>;
+
+  struct config {
+    /**
+     * Timers due within that time are run together, even if it means running
+     * some of them earlier.
+     */
+    std::chrono::milliseconds slack{50};
+
+    /**
+     * Minimal present interval until any refresh duration is measured, and
+     * the lower bound for it afterwards.
+     */
+    std::chrono::milliseconds min_present_interval{100};
+
+    /**
+     * The measured refresh duration gets multiplied by that to leave the
+     * panel some headroom.
+     */
+    double refresh_headroom = 1.2;
+  };
+
+private:
+  struct timer {
+    clock::time_point due;
+    clock::duration interval; // zero for one-shot timers
+    callback cb;
+  };
+
+  struct animation {
+    clock::time_point start;
+    clock::duration duration;
+    animation_callback cb;
+  };
+
+  event_loop &m_loop;
+  event_loop::timer_id m_wakeup_timer;
+  callback m_present;
+  config m_config;
+
+  id m_next_id = 1;
+  std::map<id, timer> m_timers;
+  std::map<id, animation> m_animations;
+
+  bool m_dirty = false;
+  bool m_in_tick = false;
+  clock::time_point m_last_present;
+  clock::duration m_refresh_estimate{};
+
+  clock::time_point next_present_allowed() const;
+  void tick();
+  void rearm();
+
+public:
+  frame_scheduler(event_loop &loop, callback present);
+  frame_scheduler(event_loop &loop, callback present, const config &c);
+  ~frame_scheduler();
+
+  frame_scheduler(const frame_scheduler &) = delete;
+  frame_scheduler &operator=(const frame_scheduler &) = delete;
+
+  /**
+   * Call the callback after the interval.
+   * @param repeat keep calling it every interval until cancelled
+   */
+  id add_timer(std::chrono::nanoseconds interval, callback cb,
+               bool repeat = true);
+
+  /**
+   * Step the animation once per present until the duration elapses.
+   */
+  id add_animation(std::chrono::nanoseconds duration, animation_callback cb);
+
+  /**
+   * Cancel a timer or an animation.
+   */
+  void cancel(id i);
+
+  /**
+   * Mark the UI as changed. The present callback will be called as soon as
+   * the refresh budget allows.
+   */
+  void request_present();
+
+  /**
+   * Feed a measured display refresh duration to the scheduler.
+   */
+  void note_refresh_duration(std::chrono::nanoseconds duration);
+
+  std::chrono::nanoseconds min_present_interval() const;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "touch.h"
+
+#include <variant>
+
+/**
+ * Anything that can be dispatched through the UI element tree.
+ *
+ * New kinds of events (gestures, timers, ...) are added as new alternatives,
+ * so the signature of ui::element::process_event stays the same. Dispatch is
+ * done with std::visit: no RTTI, and events are passed by const reference
+ * all the way down the tree.
+ */
+using ui_event = std::variant<event>;
@@ -29,6 +29,7 @@ public:
 
   point operator+(const point &other) const;
   point operator-(const point &other) const;
+  bool operator==(const point &other) const = default;
 };
 
 } // namespace geometry
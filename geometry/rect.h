@@ -118,6 +118,8 @@ public:
    * @return rectangle which contains both of rectangles.
    */
   rect outline(const rect &other) const;
+
+  bool operator==(const rect &other) const = default;
 };
 
 } // namespace geometry
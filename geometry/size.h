@@ -26,6 +26,8 @@ public:
   void set_size(int width, int height);
 
   unsigned area() const;
+
+  bool operator==(const size &other) const = default;
 };
 
 } // namespace geometry
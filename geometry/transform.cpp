@@ -0,0 +1,141 @@
+#include "transform.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace geometry {
+
+static transform::coefficient to_fixed_point(double value) {
+  return std::llround(value * transform::one);
+}
+
+transform::transform(const coefficients_t &fixed_point_coefficients)
+    : m_coeffs(fixed_point_coefficients) {}
+
+transform transform::from_matrix(double a, double b, double c, double d,
+                                 double e, double f) {
+  return transform({to_fixed_point(a), to_fixed_point(b), to_fixed_point(c),
+                    to_fixed_point(d), to_fixed_point(e), to_fixed_point(f)});
+}
+
+transform transform::fit(const std::vector<sample> &samples) {
+  if (samples.size() < 3)
+    throw std::invalid_argument("At least 3 samples are required for a fit");
+
+  // Solve the normal equations for centered coordinates; that keeps the
+  // numbers small and the system well conditioned.
+  double n = samples.size();
+  double mean_x = 0, mean_y = 0, mean_u = 0, mean_v = 0;
+  for (const auto &s : samples) {
+    mean_x += s.from.x();
+    mean_y += s.from.y();
+    mean_u += s.to.x();
+    mean_v += s.to.y();
+  }
+  mean_x /= n;
+  mean_y /= n;
+  mean_u /= n;
+  mean_v /= n;
+
+  double xx = 0, xy = 0, yy = 0, xu = 0, yu = 0, xv = 0, yv = 0;
+  for (const auto &s : samples) {
+    double x = s.from.x() - mean_x;
+    double y = s.from.y() - mean_y;
+    double u = s.to.x() - mean_u;
+    double v = s.to.y() - mean_v;
+
+    xx += x * x;
+    xy += x * y;
+    yy += y * y;
+    xu += x * u;
+    yu += y * u;
+    xv += x * v;
+    yv += y * v;
+  }
+
+  double determinant = xx * yy - xy * xy;
+  if (std::abs(determinant) <= 1e-9 * xx * yy || xx == 0 || yy == 0)
+    throw std::invalid_argument("Calibration samples lie on a single line");
+
+  double a = (xu * yy - yu * xy) / determinant;
+  double b = (yu * xx - xu * xy) / determinant;
+  double d = (xv * yy - yv * xy) / determinant;
+  double e = (yv * xx - xv * xy) / determinant;
+  double c = mean_u - a * mean_x - b * mean_y;
+  double f = mean_v - d * mean_x - e * mean_y;
+
+  return from_matrix(a, b, c, d, e, f);
+}
+
+transform transform::load(const std::filesystem::path &p) {
+  std::ifstream input(p);
+  if (!input.good()) {
+    std::stringstream error;
+    error << "Failed to open file: " << p;
+    throw std::runtime_error(error.str());
+  }
+
+  transform result;
+  input >> result;
+  return result;
+}
+
+void transform::save(const std::filesystem::path &p) const {
+  std::ofstream output(p, std::ios::trunc);
+  if (!output.good()) {
+    std::stringstream error;
+    error << "Failed to open file: " << p;
+    throw std::runtime_error(error.str());
+  }
+
+  output << *this << std::endl;
+}
+
+const transform::coefficients_t &transform::coefficients() const {
+  return m_coeffs;
+}
+
+transform::coefficients_t &transform::coefficients_ref() { return m_coeffs; }
+
+bool transform::is_identity() const { return m_coeffs == transform().m_coeffs; }
+
+point transform::map(const point &p) const { return map(p.x(), p.y()); }
+
+point transform::map(int x, int y) const {
+  const auto &[a, b, c, d, e, f] = m_coeffs;
+  const coefficient half = one >> 1;
+
+  return {static_cast<int>((a * x + b * y + c + half) >> fraction_bits),
+          static_cast<int>((d * x + e * y + f + half) >> fraction_bits)};
+}
+
+} // namespace geometry
+
+std::istream &operator>>(std::istream &stream, geometry::transform &t) {
+  static const std::string stream_mark = "transform={";
+
+  std::string str_input;
+  stream >> str_input;
+
+  if (str_input != stream_mark)
+    throw std::invalid_argument("Unexpected input");
+
+  for (auto &coefficient : t.coefficients_ref())
+    stream >> coefficient;
+
+  stream >> str_input;
+  if (!stream || str_input != "}")
+    throw std::invalid_argument("Unexpected input");
+
+  return stream;
+}
+
+std::ostream &operator<<(std::ostream &stream, const geometry::transform &t) {
+  stream << "transform={";
+  for (auto coefficient : t.coefficients())
+    stream << " " << coefficient;
+  stream << " }";
+  return stream;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <stdint.h>
+#include <vector>
+
+#include "point.h"
+
+namespace geometry {
+
+/**
+ * Affine transform in fixed point arithmetic:
+ *   x' = (a * x + b * y + c) / 2^fraction_bits
+ *   y' = (d * x + e * y + f) / 2^fraction_bits
+ * Mapping a point takes a few integer multiplications and additions only,
+ * so it is cheap enough to be applied to every touch sample.
+ */
+class transform {
+public:
+  using coefficient = int64_t;
+  using coefficients_t = std::array<coefficient, 6>;
+  static const int fraction_bits = 16;
+  static const coefficient one = coefficient(1) << fraction_bits;
+
+  /**
+   * Pair of a measured (source) point and the point it should be mapped to.
+   */
+  struct sample {
+    point from;
+    point to;
+  };
+
+private:
+  // a, b, c, d, e, f; see the class description.
+  coefficients_t m_coeffs = {one, 0, 0, 0, one, 0};
+
+public:
+  transform() = default;
+  transform(const coefficients_t &fixed_point_coefficients);
+
+  /**
+   * Build a transform out of floating point coefficients.
+   */
+  static transform from_matrix(double a, double b, double c, double d,
+                               double e, double f);
+
+  /**
+   * Fit a transform to a set of samples using the least squares method. Three
+   * samples give an exact solution, more samples average out measurement
+   * errors.
+   * @param samples at least 3 samples, not lying on a single line
+   * @return the transform, which maps sample::from onto sample::to as close
+   * as possible.
+   */
+  static transform fit(const std::vector<sample> &samples);
+
+  /**
+   * Read the transform from a file written by transform::save
+   */
+  static transform load(const std::filesystem::path &p);
+  void save(const std::filesystem::path &p) const;
+
+  const coefficients_t &coefficients() const;
+  coefficients_t &coefficients_ref();
+
+  bool is_identity() const;
+
+  point map(const point &p) const;
+  point map(int x, int y) const;
+};
+
+} // namespace geometry
+
+std::istream &operator>>(std::istream &stream, geometry::transform &t);
+std::ostream &operator<<(std::ostream &stream, const geometry::transform &t);
@@ -1,4 +1,5 @@
 // By gh/BortEngineerDude
+#include <algorithm>
 #include <ranges>
 #include <thread>
 #include <unordered_set>
@@ -11,6 +12,8 @@ using namespace bytes;
 static const auto lock_control_register = be((uint16_t)0x8040);
 static const auto config_register = be((uint16_t)0x8051);
 static const auto config_size = 5;
+static const uint16_t config_block_address = 0x8050;
+static const auto config_write_chunk = 32;
 static const auto touch_status_register = be((uint16_t)0x814e);
 static const auto lock_status_register = be((uint16_t)0x814c);
 static const auto id_register = be((uint16_t)0x8140);
@@ -23,6 +26,51 @@ void gt1158::read_config() {
   parser >> m_config.max_x >> m_config.max_y >> m_config.max_touch_points;
 }
 
+uint16_t gt1158::config_checksum(const vect &block) {
+  // Sum of big endian 16-bit words, excluding the checksum itself and the
+  // "config fresh" flag; the checksum makes the total sum zero.
+  const auto data_size = config_block::size - 3;
+  uint16_t sum = 0;
+
+  for (int i = 0; i < data_size; i += 2) {
+    uint16_t word = block[i] << 8;
+    if (i + 1 < data_size)
+      word |= block[i + 1];
+    sum += word;
+  }
+
+  return static_cast<uint16_t>(0 - sum);
+}
+
+std::chrono::milliseconds gt1158::config_block::report_period() const {
+  return std::chrono::milliseconds(5 + (refresh_rate & 0x0f));
+}
+
+void gt1158::config_block::set_report_period(
+    std::chrono::milliseconds period) {
+  auto value = std::clamp<int>(period.count() - 5, 0, 0x0f);
+  refresh_rate = (refresh_rate & 0xf0) | value;
+}
+
+std::chrono::seconds gt1158::config_block::idle_timeout() const {
+  return std::chrono::seconds(low_power_control & 0x0f);
+}
+
+void gt1158::config_block::set_idle_timeout(std::chrono::seconds timeout) {
+  auto value = std::clamp<int>(timeout.count(), 0, 0x0f);
+  low_power_control = (low_power_control & 0xf0) | value;
+}
+
+double gt1158::rate_measurement::interrupt_rate() const {
+  auto seconds = std::chrono::duration<double>(duration).count();
+  return seconds > 0 ? interrupts / seconds : 0;
+}
+
+double gt1158::rate_measurement::report_rate() const {
+  auto seconds = std::chrono::duration<double>(duration).count();
+  return seconds > 0 ? reports / seconds : 0;
+}
+
 gt1158::gt1158(i2c::controller::ptr controller, gpiod::line &&interrupt,
                gpiod::line &&reset)
     : i2c::peripheral(controller, 0x14), m_interrupt_line(interrupt),
@@ -60,6 +108,151 @@ std::string gt1158::get_id() {
 
 gt1158::config gt1158::get_config() { return m_config; }
 
+gt1158::config_block gt1158::read_config_block() {
+  config_block block;
+  block.raw = read(be(config_block_address), config_block::size);
+
+  const auto checksum_offset = config_block::size - 3;
+  uint16_t stored_checksum =
+      (block.raw[checksum_offset] << 8) | block.raw[checksum_offset + 1];
+  if (stored_checksum != config_checksum(block.raw)) {
+    std::stringstream error;
+    error << "GT1158: config block checksum mismatch: stored 0x" << std::hex
+          << stored_checksum << ", calculated 0x"
+          << config_checksum(block.raw);
+    throw std::runtime_error(error.str());
+  }
+
+  buffer parser(block.raw, endian::little);
+  parser >> block.version >> block.max_x >> block.max_y >>
+      block.max_touch_points >> block.module_switch_1 >>
+      block.module_switch_2 >> block.shake_count >> block.filter >>
+      block.large_touch >> block.noise_reduction >> block.touch_level >>
+      block.leave_level >> block.low_power_control >> block.refresh_rate >>
+      block.x_threshold >> block.y_threshold;
+
+  return block;
+}
+
+void gt1158::write_config_block(const config_block &block) {
+  if (m_locked)
+    throw std::runtime_error("GT1158: can't write config while locked");
+
+  if (block.raw.size() != config_block::size)
+    throw std::invalid_argument(
+        "GT1158: config block must be obtained by read_config_block");
+
+  if (block.max_touch_points < 1 || block.max_touch_points > 5 ||
+      !block.max_x || !block.max_y)
+    throw std::invalid_argument("GT1158: invalid config block values");
+
+  vect data = block.raw;
+  size_t offset = 0;
+  auto put = [&data, &offset](auto value) {
+    auto serialized = le(value);
+    std::copy(serialized.begin(), serialized.end(), data.begin() + offset);
+    offset += serialized.size();
+  };
+
+  put(block.version);
+  put(block.max_x);
+  put(block.max_y);
+  put(block.max_touch_points);
+  put(block.module_switch_1);
+  put(block.module_switch_2);
+  put(block.shake_count);
+  put(block.filter);
+  put(block.large_touch);
+  put(block.noise_reduction);
+  put(block.touch_level);
+  put(block.leave_level);
+  put(block.low_power_control);
+  put(block.refresh_rate);
+  put(block.x_threshold);
+  put(block.y_threshold);
+
+  const auto checksum_offset = config_block::size - 3;
+  auto checksum = config_checksum(data);
+  data[checksum_offset] = checksum >> 8;
+  data[checksum_offset + 1] = checksum & 0xff;
+  data[checksum_offset + 2] = 1; // "config fresh": apply the new config
+
+  for (int chunk = 0; chunk < config_block::size;
+       chunk += config_write_chunk) {
+    auto chunk_end = std::min(chunk + config_write_chunk, config_block::size);
+    write(be(static_cast<uint16_t>(config_block_address + chunk)),
+          vect(data.begin() + chunk, data.begin() + chunk_end));
+  }
+
+  // Give the controller some time to apply the config
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  auto written = read(be(config_block_address), checksum_offset + 2);
+  if (!std::equal(written.begin(), written.end(), data.begin())) {
+    // The controller may ignore the config if the version is lower than the
+    // one it has; no point in trying to continue with a half-known state.
+    throw std::runtime_error("GT1158: config block verification failed");
+  }
+
+  m_touch_track.clear();
+  read_config();
+}
+
+gt1158::rate_measurement
+gt1158::measure_interrupt_rate(std::chrono::nanoseconds duration) {
+  rate_measurement result;
+  result.report_period = read_config_block().report_period();
+
+  m_interrupt_line.event_read_multiple(); // drop stale interrupts
+
+  auto begin = std::chrono::steady_clock::now();
+  auto deadline = begin + duration;
+  auto now = begin;
+
+  while (now < deadline) {
+    if (m_interrupt_line.event_wait(deadline - now)) {
+      result.interrupts += m_interrupt_line.event_read_multiple().size();
+
+      auto touch_status = read(touch_status_register, 1)[0];
+      if (touch_status) {
+        if ((touch_status & 0x0f) != 0)
+          ++result.reports;
+        write(touch_status_register, {0});
+      }
+    }
+
+    now = std::chrono::steady_clock::now();
+  }
+
+  result.duration = now - begin;
+  m_touch_track.clear();
+
+  return result;
+}
+
+std::vector<gt1158::rate_measurement> gt1158::measure_report_periods(
+    const std::vector<std::chrono::milliseconds> &periods,
+    std::chrono::nanoseconds duration_each) {
+  const auto original = read_config_block();
+  std::vector<rate_measurement> result;
+  result.reserve(periods.size());
+
+  try {
+    for (auto period : periods) {
+      auto block = original;
+      block.set_report_period(period);
+      write_config_block(block);
+      result.emplace_back(measure_interrupt_rate(duration_each));
+    }
+  } catch (...) {
+    write_config_block(original);
+    throw;
+  }
+
+  write_config_block(original);
+  return result;
+}
+
 void gt1158::reset() {
   m_locked = false;
   const auto pause = std::chrono::milliseconds(50);
@@ -82,6 +275,19 @@ void gt1158::lock() {
 
 void gt1158::set_inverted(bool inverted) { m_inverted = inverted; }
 
+void gt1158::set_calibration(const geometry::transform &t) {
+  m_calibration = t;
+  m_touch_track.clear();
+}
+
+geometry::transform gt1158::calibration() const { return m_calibration; }
+
+void gt1158::set_report_observer(report_observer observer) {
+  m_report_observer = std::move(observer);
+}
+
+int gt1158::event_fd() const { return m_interrupt_line.event_get_fd(); }
+
 bool gt1158::wait_for_events(const std::chrono::nanoseconds &timeout) {
   return m_interrupt_line.event_wait(timeout);
 }
@@ -113,6 +319,9 @@ std::vector<event> gt1158::get_events() {
     uint8_t touch_count = touch_status & 0x0f;
 
     if (touch_count < 1 || touch_count > 5) {
+      if (m_report_observer)
+        m_report_observer({touch_status});
+
       if (m_touch_track.empty())
         return {};
       else {
@@ -129,6 +338,9 @@ std::vector<event> gt1158::get_events() {
     }
 
     auto touches = read(touch_status_register, 1 + touch_count * 8);
+    if (m_report_observer)
+      m_report_observer(touches);
+
     buffer parser(touches, endian::little);
     parser.seek(1); // skip over the first status byte
 
@@ -142,6 +354,12 @@ std::vector<event> gt1158::get_events() {
       event ev;
       parser >> ev.touch_id >> ev.x >> ev.y >> ev.size;
 
+      if (!m_calibration.is_identity()) {
+        auto [x, y] = m_calibration.map(ev.x, ev.y).coords();
+        ev.x = std::clamp(x, 0, 0xffff);
+        ev.y = std::clamp(y, 0, 0xffff);
+      }
+
       if (m_touch_track.contains(ev.touch_id)) {
         released_touch_ids.erase(ev.touch_id);
 
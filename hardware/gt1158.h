@@ -4,8 +4,10 @@
 #include "i2c.h"
 
 #include <touch.h>
+#include <transform.h>
 
 #include <chrono>
+#include <functional>
 #include <gpiod.hpp>
 #include <unordered_map>
 #include <vector>
@@ -18,7 +20,62 @@ public:
     uint16_t max_y = 0;
   };
 
+  /**
+   * The complete configuration block of the controller (0x8050 - 0x813f).
+   *
+   * The layout of the typed fields follows the one used by other Goodix
+   * GT9xx/GT1x controllers, as no GT1158 datasheet could be found. All the
+   * remaining bytes are kept untouched in raw, and gt1158::write_config_block
+   * refuses to write a block which failed the checksum verification on read.
+   */
+  struct config_block {
+    static constexpr int size = 240;
+
+    uint8_t version = 0;
+    uint16_t max_x = 0;
+    uint16_t max_y = 0;
+    uint8_t max_touch_points = 0;
+    uint8_t module_switch_1 = 0;
+    uint8_t module_switch_2 = 0;
+    uint8_t shake_count = 0;
+    uint8_t filter = 0;
+    uint8_t large_touch = 0;
+    uint8_t noise_reduction = 0;
+    uint8_t touch_level = 0; // signal threshold to detect a touch
+    uint8_t leave_level = 0; // signal threshold to detect a release
+    uint8_t low_power_control = 0;
+    uint8_t refresh_rate = 0;
+    uint8_t x_threshold = 0; // coordinate change needed to report a move
+    uint8_t y_threshold = 0;
+
+    bytes::vect raw; // the whole block as read from the controller
+
+    /**
+     * Interval between two coordinate reports, 5 to 20 ms.
+     */
+    std::chrono::milliseconds report_period() const;
+    void set_report_period(std::chrono::milliseconds period);
+
+    /**
+     * Time without touches after which the controller enters the low power
+     * mode, 0 to 15 s.
+     */
+    std::chrono::seconds idle_timeout() const;
+    void set_idle_timeout(std::chrono::seconds timeout);
+  };
+
+  struct rate_measurement {
+    std::chrono::milliseconds report_period{};
+    std::chrono::nanoseconds duration{};
+    size_t interrupts = 0;
+    size_t reports = 0; // interrupts which had at least one touch to report
+
+    double interrupt_rate() const; // per second
+    double report_rate() const;    // per second
+  };
+
   using event_map = std::unordered_map<uint8_t, event>;
+  using report_observer = std::function<void(const bytes::vect &)>;
 
 private:
   gpiod::line m_interrupt_line;
@@ -28,9 +85,13 @@ private:
   config m_config;
   bool m_locked = false;
   bool m_inverted = true;
+  geometry::transform m_calibration;
+  report_observer m_report_observer;
 
   void read_config();
 
+  static uint16_t config_checksum(const bytes::vect &block);
+
 public:
   gt1158(i2c::controller::ptr controller, gpiod::line &&interrupt,
          gpiod::line &&reset);
@@ -48,9 +109,60 @@ public:
 
   void set_inverted(bool inverted);
 
+  /**
+   * Set the transform which maps raw touch panel coordinates onto display
+   * coordinates. It is applied to every touch sample while decoding, so all
+   * events produced by gt1158::get_events are already in display coordinates.
+   * See geometry::transform::fit to obtain one out of calibration samples.
+   */
+  void set_calibration(const geometry::transform &t);
+  geometry::transform calibration() const;
+
   std::string get_id();
   config get_config();
 
+  /**
+   * Read and verify the complete configuration block.
+   */
+  config_block read_config_block();
+
+  /**
+   * Write the configuration block back to the controller. The checksum is
+   * recalculated, the written block is read back and verified, and the
+   * short configuration (gt1158::get_config) is updated.
+   * @param block a block obtained by gt1158::read_config_block and modified
+   */
+  void write_config_block(const config_block &block);
+
+  /**
+   * Count interrupts and coordinate reports for the given duration. Keep a
+   * finger on the panel during the measurement to measure the report rate;
+   * otherwise it measures the idle wakeup rate. Touches are not tracked
+   * during the measurement, and no events are generated for them.
+   */
+  rate_measurement measure_interrupt_rate(std::chrono::nanoseconds duration);
+
+  /**
+   * Apply each report period in turn and measure the achieved rates. The
+   * original configuration is restored afterwards.
+   */
+  std::vector<rate_measurement>
+  measure_report_periods(const std::vector<std::chrono::milliseconds> &periods,
+                         std::chrono::nanoseconds duration_each);
+
+  /**
+   * Set a function to be called with every raw coordinate report read from
+   * the controller (the status byte followed by touch point data), before it
+   * is decoded. Meant for recording touch sessions.
+   */
+  void set_report_observer(report_observer observer);
+
+  /**
+   * File descriptor of the interrupt line, which becomes readable when the
+   * controller has events to report; for use with event_loop.
+   */
+  int event_fd() const;
+
   bool wait_for_events(const std::chrono::nanoseconds &timeout);
   std::vector<event> get_events();
 };
@@ -209,6 +209,9 @@ void waveshare_eink::put_bitmap(ui::bitmap b, const geometry::point &to) {
 }
 
 void waveshare_eink::pre_upload() {
+  // The previous refresh might still be in progress if not waited for.
+  wait_for_busy();
+
   if (m_refresh_mode == refresh_mode::full ||
       m_auto_full_refresh == auto_refresh_mode::none || m_auto_refreshing)
     return;
@@ -265,20 +268,73 @@ void waveshare_eink::refresh_display(refresh_mode m) {
 
   send_command(command::display_update_control_2, mode_payload);
   send_command(command::begin_update);
-  wait_for_busy();
+
+  m_refreshing = true;
+  m_refresh_started = std::chrono::steady_clock::now();
+
+  if (m_wait_for_refresh)
+    wait_for_busy();
 }
 
 void waveshare_eink::wait_for_busy(std::chrono::nanoseconds timeout) {
   if (m_busy.get_value()) { // if the EInk display is currently busy...
+    const std::chrono::nanoseconds slice = std::chrono::milliseconds(100);
     auto begin = std::chrono::steady_clock::now();
-    m_busy.event_read_multiple(); // clear any pending events
-    m_busy.event_wait(timeout);   // wait for a falling edge event
-    m_busy.event_read_multiple(); // consume all new events
     auto duration = std::chrono::steady_clock::now() - begin;
+
+    while (m_busy.get_value()) {
+      auto wait = slice;
+      if (timeout.count()) {
+        if (duration >= timeout)
+          break;
+        wait = std::min(slice, timeout - duration);
+      }
+
+      if (m_busy.event_wait(wait)) // wait for a falling edge event
+        m_busy.event_read_multiple(); // consume all new events
+
+      duration = std::chrono::steady_clock::now() - begin;
+    }
+
     std::cout << "Spent "
               << std::chrono::duration_cast<std::chrono::milliseconds>(duration)
               << " ms busy waiting" << std::endl;
   }
+
+  if (!m_busy.get_value())
+    finish_refresh();
+}
+
+void waveshare_eink::finish_refresh() {
+  if (!m_refreshing)
+    return;
+
+  m_refreshing = false;
+  m_last_refresh_duration =
+      std::chrono::steady_clock::now() - m_refresh_started;
+}
+
+void waveshare_eink::set_wait_for_refresh(bool wait) {
+  m_wait_for_refresh = wait;
+}
+
+int waveshare_eink::busy_fd() const { return m_busy.event_get_fd(); }
+
+bool waveshare_eink::handle_busy_event() {
+  if (m_busy.event_wait(std::chrono::nanoseconds::zero()))
+    m_busy.event_read_multiple();
+
+  if (busy())
+    return false;
+
+  finish_refresh();
+  return true;
+}
+
+bool waveshare_eink::busy() const { return m_busy.get_value(); }
+
+std::chrono::nanoseconds waveshare_eink::last_refresh_duration() const {
+  return m_last_refresh_duration;
 }
 
 void waveshare_eink::set_draw_region(uint16_t start_x, uint16_t start_y,
@@ -297,4 +353,20 @@ void waveshare_eink::set_draw_offset(uint16_t x, uint16_t y) {
   send_command(command::draw_offset_y, le(y));
 }
 
-void waveshare_eink::power_off() { send_command(command::deep_sleep, 1); }
+void waveshare_eink::put_region(const ui::bitmap &frame,
+                                const geometry::rect &area) {
+  auto rows = frame.geometry();
+  rows.set_position(0, area.pos().y());
+  rows.set_size(rows.size().width(), area.size().height());
+  rows = frame.geometry().overlap(rows);
+
+  if (rows.area() == 0)
+    return;
+
+  put_bitmap(frame.cropped(rows), rows.pos());
+}
+
+void waveshare_eink::power_off() {
+  wait_for_busy();
+  send_command(command::deep_sleep, 1);
+}
@@ -56,6 +56,13 @@ private:
   uint m_max_part_refreshes = 5;
   bool m_auto_refreshing = false;
 
+  bool m_wait_for_refresh = true;
+  bool m_refreshing = false;
+  std::chrono::steady_clock::time_point m_refresh_started;
+  std::chrono::nanoseconds m_last_refresh_duration{};
+
+  void finish_refresh();
+
   /**
    * Perform a hard reset followed by a soft reset.
    */
@@ -106,11 +113,52 @@ public:
   void set_display_size(int width, int height);
   void set_refresh_mode(refresh_mode m);
 
+  /**
+   * Choose whether to block until the display refresh is done (the default),
+   * or to return right after starting it. In the latter case watch busy_fd()
+   * and call handle_busy_event() when it becomes readable; any operation
+   * started before the refresh is done will wait for it.
+   */
+  void set_wait_for_refresh(bool wait);
+
+  /**
+   * File descriptor of the BUSY line, which becomes readable when the display
+   * finishes a refresh; for use with event_loop.
+   */
+  int busy_fd() const;
+
+  /**
+   * Consume BUSY line events.
+   * @return true if the display is not busy anymore
+   */
+  bool handle_busy_event();
+
+  bool busy() const;
+
+  /**
+   * Duration of the last finished refresh.
+   */
+  std::chrono::nanoseconds last_refresh_duration() const;
+
   rect geometry() const;
+
+  /**
+   * Block while the display is busy.
+   * @param timeout give up after that time; zero means no timeout
+   */
   void wait_for_busy(std::chrono::nanoseconds timeout = {});
   void clear(bool clear_to_black = false);
   void set_raw_framebuffer(const vect &framebuffer);
   void put_bitmap(ui::bitmap b, const geometry::point &to = {});
 
+  /**
+   * Upload only the part of a full screen bitmap which has changed.
+   * The panel RAM is uploaded in whole rows, so the area is extended to the
+   * full width of the display.
+   * @param frame full screen bitmap
+   * @param area changed area of the frame
+   */
+  void put_region(const ui::bitmap &frame, const geometry::rect &area);
+
   void power_off();
 };
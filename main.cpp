@@ -1,8 +1,16 @@
 // By gh/BortEngineerDude
 
 #include <button.h>
+#include <coalescer.h>
+#include <element_arena.h>
+#include <event_loop.h>
+#include <filter.h>
 #include <gt1158.h>
 #include <i2c.h>
+#include <layout.h>
+#include <recording.h>
+#include <render_thread.h>
+#include <scheduler.h>
 #include <waveshare_eink.h>
 
 #include <chrono>
@@ -18,7 +26,12 @@ std::string timestamp() {
   return ss.str();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+  // einktouch --record <file>: save the touch session for einktouch-replay.
+  std::unique_ptr<recording::recorder> recorder;
+  if (argc == 3 && std::string(argv[1]) == "--record")
+    recorder = std::make_unique<recording::recorder>(argv[2]);
+
   i2c::fs::path touch_dev = "/dev/i2c-1";
   spi::fs::path display_dev = "/dev/spidev0.0";
   gpiod::chip gpio("0");
@@ -27,29 +40,70 @@ int main() {
   i2c_controller->open();
 
   gt1158 touchscreen(i2c_controller, gpio.get_line(118), gpio.get_line(32));
+
+  // Produced by geometry::transform::save, if the panel has been calibrated.
+  const std::filesystem::path calibration_file =
+      "/opt/einktouch/touch_calibration";
+  if (std::filesystem::exists(calibration_file))
+    touchscreen.set_calibration(geometry::transform::load(calibration_file));
+
+  if (recorder)
+    touchscreen.set_report_observer(
+        [&recorder](const bytes::vect &raw) { recorder->record_report(raw); });
+
   waveshare_eink eink(display_dev, gpio.get_line(117), gpio.get_line(65),
                       gpio.get_line(110));
 
-  const std::chrono::seconds poll_duration(1);
+  // Merge drags which piled up during a display refresh, so that the
+  // dispatch work depends on the number of touches only.
+  const bool coalesce_drags = true;
+  touch_coalescer coalescer;
+
+  // Drop drags caused by a jitter of a finger which is not actually moving.
+  const bool filter_jitter = true;
+  touch_filter jitter_filter;
 
   ui::element root(eink.geometry(), nullptr);
-  auto s1 = new ui::element({10, 10, 100, 90}, &root);
-  auto b11 = new ui::button({10, 10, 80, 30}, s1);
-  auto b12 = new ui::button({10, 50, 80, 30}, s1);
+
+  // Owns the widgets of the screen; destroyed before the root.
+  ui::element_arena screen;
+  using geometry::rect;
+
+  // Two panels of buttons, laid out from top to bottom.
+  const int gap = 10;
+  const rect button_size(0, 0, 80, 30);
+  const uint corner_radius = 6;
+
+  auto panels = screen.create<ui::column_layout>(root.geometry(), &root);
+  panels->set_padding(gap);
+  panels->set_spacing(gap);
+
+  auto s1 = screen.create<ui::column_layout>(rect(), panels);
+  s1->set_padding(gap);
+  s1->set_spacing(gap);
+
+  auto b11 = screen.create<ui::button>(button_size, s1);
+  auto b12 = screen.create<ui::button>(button_size, s1);
 
   b11->set_toggleable(true);
   b12->set_toggleable(true);
 
-  auto s2 = new ui::element({10, 110, 100, 135}, &root);
-  auto b21 = new ui::button({10, 10, 80, 30}, s2);
-  auto b22 = new ui::button({10, 50, 80, 30}, s2);
-  auto b23 = new ui::button({10, 90, 80, 30}, s2);
+  auto s2 = screen.create<ui::column_layout>(rect(), panels);
+  s2->set_padding(gap);
+  s2->set_spacing(gap);
+
+  auto b21 = screen.create<ui::button>(button_size, s2);
+  auto b22 = screen.create<ui::button>(button_size, s2);
+  auto b23 = screen.create<ui::button>(button_size, s2);
+
+  for (auto b : {b11, b12, b21, b22, b23})
+    b->set_corner_radius(corner_radius);
 
   root.render_all();
   eink.clear();
   eink.put_bitmap(root.get_bitmap());
 
-  bool running = true;
+  event_loop loop;
   waveshare_eink::refresh_mode refresh = waveshare_eink::refresh_mode::patrial;
   waveshare_eink::auto_refresh_mode auto_refresh =
       waveshare_eink::auto_refresh_mode::none;
@@ -60,7 +114,12 @@ int main() {
   auto toggled = [](bool toggled) {
     std::cout << "Toggled: " << std::boolalpha << toggled << std::endl;
   };
-  auto switch_refresh_mode = [&eink, &auto_refresh, &root]() {
+
+  // Image on the panel, as last uploaded.
+  ui::bitmap presented = root.get_bitmap();
+
+  // Changes the display, so it runs on the loop thread.
+  auto switch_refresh_mode = [&eink, &auto_refresh, &presented]() {
     std::cout << "Auto refresh mode: ";
 
     switch (auto_refresh) {
@@ -82,37 +141,101 @@ int main() {
 
     eink.clear();
     eink.set_auto_refresh(auto_refresh);
-    eink.put_bitmap(root.get_bitmap());
+    eink.put_bitmap(presented);
   };
-  auto exit = [&running]() { running = false; };
+  auto exit = [&loop]() { loop.stop(); };
 
   b11->set_toggled_callback(toggled);
 
   b21->set_clicked_callback(clicked);
-  b22->set_clicked_callback(switch_refresh_mode);
+  b22->set_clicked_callback(
+      [&loop, switch_refresh_mode]() { loop.post(switch_refresh_mode); });
   b23->set_clicked_callback(exit);
 
-  while (running) {
-    if (touchscreen.wait_for_events(poll_duration)) {
-      auto events = touchscreen.get_events();
-      if (events.empty())
-        continue;
+  // Upload the latest rendered frame, or postpone it until the display is
+  // done with the ongoing refresh.
+  std::unique_ptr<ui::render_thread> renderer;
+  auto present = [&eink, &renderer, &presented, &need_update]() {
+    if (eink.busy()) {
+      need_update = true;
+      return;
+    }
+
+    need_update = false;
+    if (!renderer->take_frame())
+      return;
+
+    const auto &frame = renderer->frame();
+    auto changed = frame.changed_rows(presented);
+    if (changed.area() > 0) {
+      eink.put_region(frame, changed);
+      presented = frame;
+    }
+  };
+
+  // Limits presents to the rate the panel can actually deliver.
+  frame_scheduler scheduler(loop, present);
+
+  // From here on, the element tree belongs to the render thread; it renders
+  // while the loop thread reads touches and uploads the previous frame.
+  renderer = std::make_unique<ui::render_thread>(root, [&loop, &scheduler]() {
+    loop.post([&scheduler]() { scheduler.request_present(); });
+  });
 
-      std::cout << timestamp() << " Got " << events.size() << " events:\n";
-      for (const auto &ev : events) {
-        std::cout << " " << ev << "\n";
+  auto read_events = [&touchscreen, &jitter_filter, &recorder]() {
+    auto events = touchscreen.get_events();
+    if (recorder && !events.empty())
+      recorder->record_events(events);
 
-        if (root.process_event(ev))
-          need_update = true;
-      }
+    return filter_jitter ? jitter_filter.filter(events) : events;
+  };
+
+  loop.add_fd(touchscreen.event_fd(), [&]() {
+    auto events = read_events();
 
-      if (need_update) {
-        need_update = false;
-        eink.put_bitmap(root.get_bitmap());
-      }
+    if (coalesce_drags) {
+      coalescer.push(events);
+      while (touchscreen.wait_for_events(std::chrono::nanoseconds::zero()))
+        coalescer.push(read_events());
 
-      std::cout << std::endl;
+      events = coalescer.take();
     }
+
+    if (events.empty())
+      return;
+
+    std::cout << timestamp() << " Got " << events.size() << " events:\n";
+    for (const auto &ev : events)
+      std::cout << " " << ev << "\n";
+    std::cout << std::endl;
+
+    renderer->post([&root, events]() {
+      for (const auto &ev : events)
+        root.process_event(ev);
+    });
+  });
+
+  loop.add_fd(eink.busy_fd(), [&]() {
+    if (!eink.handle_busy_event())
+      return;
+
+    scheduler.note_refresh_duration(eink.last_refresh_duration());
+    if (need_update)
+      present();
+  });
+
+  // Don't block the loop during refreshes; the BUSY line is watched instead.
+  eink.set_wait_for_refresh(false);
+  loop.run();
+  renderer.reset();
+
+  if (filter_jitter) {
+    auto stats = jitter_filter.get_statistics();
+    std::cout << "Touch filter passed " << stats.passed
+              << " events, suppressed " << stats.suppressed_dead_zone
+              << " in dead zone and "
+              << stats.suppressed_size_only << " size-only changes"
+              << std::endl;
   }
 
   eink.clear();
@@ -0,0 +1,133 @@
+// Checks ui::blit against a pixel by pixel reference, for every raster
+// operation, with and without a mask, at any bit alignment, partly outside
+// of either bitmap, and within a single bitmap with overlapping areas.
+
+#include <blit.h>
+
+#include <iostream>
+#include <random>
+
+using geometry::point;
+using geometry::rect;
+using geometry::size;
+
+static int failures = 0;
+
+static ui::bitmap random_bitmap(std::mt19937 &rng, int width, int height) {
+  ui::bitmap b(size(width, height));
+  for (auto &byte : b.raw_data())
+    byte = rng();
+  return b;
+}
+
+static bool apply(ui::raster_op op, bool dst, bool src) {
+  switch (op) {
+  case ui::raster_op::copy:
+    return src;
+  case ui::raster_op::bit_or:
+    return dst | src;
+  case ui::raster_op::bit_and:
+    return dst & src;
+  case ui::raster_op::bit_xor:
+    return dst ^ src;
+  case ui::raster_op::and_not:
+    return dst & !src;
+  case ui::raster_op::invert:
+    return !src;
+  }
+  return src;
+}
+
+/**
+ * Blit pixel by pixel, skipping whatever is outside of either bitmap.
+ */
+static void reference_blit(const ui::bitmap &src, const rect &area,
+                           ui::bitmap &dst, const point &to, ui::raster_op op,
+                           const ui::bitmap *mask) {
+  auto [src_width, src_height] = src.geometry().size().dimensions();
+  auto [dst_width, dst_height] = dst.geometry().size().dimensions();
+
+  for (int y = 0; y < area.size().height(); ++y)
+    for (int x = 0; x < area.size().width(); ++x) {
+      int sx = area.pos().x() + x, sy = area.pos().y() + y;
+      int dx = to.x() + x, dy = to.y() + y;
+      if (sx < 0 || sy < 0 || sx >= src_width || sy >= src_height)
+        continue;
+      if (dx < 0 || dy < 0 || dx >= dst_width || dy >= dst_height)
+        continue;
+      if (mask && !mask->pixel(sx, sy))
+        continue;
+
+      dst.draw_pixel(dx, dy, apply(op, dst.pixel(dx, dy), src.pixel(sx, sy)));
+    }
+}
+
+static void check_blit(std::mt19937 &rng, int iteration) {
+  int src_width = 1 + rng() % 300, src_height = 1 + rng() % 6;
+  bool within_one = rng() % 6 == 0;
+  int dst_width = within_one ? src_width : 1 + rng() % 300;
+  int dst_height = within_one ? src_height : 1 + rng() % 6;
+
+  auto src = random_bitmap(rng, src_width, src_height);
+  auto dst = within_one ? src : random_bitmap(rng, dst_width, dst_height);
+  auto mask = random_bitmap(rng, src_width, src_height);
+  bool masked = rng() % 2;
+  auto op = ui::raster_op(rng() % 6);
+
+  rect area(int(rng() % (src_width + 20)) - 10,
+            int(rng() % (src_height + 4)) - 2, rng() % (src_width + 20),
+            rng() % (src_height + 4));
+  point to(int(rng() % (dst_width + 20)) - 10,
+           int(rng() % (dst_height + 4)) - 2);
+
+  // The reference reads from a copy, so overlapping areas within one bitmap
+  // have to come out as if the source had been copied first.
+  auto expected = dst;
+  reference_blit(src, area, expected, to, op, masked ? &mask : nullptr);
+  ui::blit(within_one ? dst : src, area, dst, to, op,
+           masked ? &mask : nullptr);
+
+  if (dst.raw_data() == expected.raw_data())
+    return;
+
+  std::cerr << "blit differs from the reference in iteration " << iteration
+            << ": op " << int(op) << (masked ? ", masked" : "")
+            << (within_one ? ", within one bitmap" : "") << ", " << area
+            << " to " << to.x() << "," << to.y() << std::endl;
+  ++failures;
+}
+
+static void check_cropped(std::mt19937 &rng, int iteration) {
+  int width = 1 + rng() % 200, height = 1 + rng() % 5;
+  auto b = random_bitmap(rng, width, height);
+  rect area(int(rng() % width), int(rng() % height), rng() % width,
+            rng() % height);
+
+  auto cropped = b.cropped(area);
+  auto overlap = b.geometry().overlap(area);
+  bool same = cropped.geometry().size() == overlap.size();
+  for (int y = 0; same && y < overlap.size().height(); ++y)
+    for (int x = 0; same && x < overlap.size().width(); ++x)
+      same = cropped.pixel(x, y) ==
+             b.pixel(overlap.pos().x() + x, overlap.pos().y() + y);
+
+  if (same)
+    return;
+
+  std::cerr << "cropped bitmap differs in iteration " << iteration
+            << std::endl;
+  ++failures;
+}
+
+int main() {
+  std::mt19937 rng(7);
+
+  for (int iteration = 0; iteration < 20000; ++iteration)
+    check_blit(rng, iteration);
+  for (int iteration = 0; iteration < 2000; ++iteration)
+    check_cropped(rng, iteration);
+
+  if (failures)
+    std::cerr << failures << " check(s) failed" << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
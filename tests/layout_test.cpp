@@ -0,0 +1,71 @@
+// Checks that layouts place their subelements wherever they sit in the
+// tree, including directly under an element which isn't a layout.
+
+#include <button.h>
+#include <element_arena.h>
+#include <layout.h>
+
+#include <iostream>
+
+using geometry::rect;
+
+static int failures = 0;
+
+static void expect_geometry(const char *what, ui::element *e,
+                            const rect &expected) {
+  auto actual = e->geometry_relative_to_parent().second;
+  if (actual == expected)
+    return;
+
+  std::cerr << what << ": expected " << expected << ", got " << actual
+            << std::endl;
+  ++failures;
+}
+
+static void column_under_root() {
+  ui::element root({0, 0, 122, 250}, nullptr);
+  ui::element_arena arena;
+
+  auto column = arena.create<ui::column_layout>(rect(0, 0, 100, 100), &root);
+  column->set_padding(5);
+  column->set_spacing(4);
+  auto first = arena.create<ui::button>(rect(0, 0, 80, 30), column);
+  auto second = arena.create<ui::button>(rect(0, 0, 80, 30), column);
+  root.render_all();
+
+  expect_geometry("first in column", first, {5, 5, 90, 30});
+  expect_geometry("second in column", second, {5, 39, 90, 30});
+
+  // Changing the spacing places the subelements again.
+  column->set_spacing(10);
+  root.render_all();
+  expect_geometry("second in respaced column", second, {5, 45, 90, 30});
+}
+
+static void grid_under_root() {
+  ui::element root({0, 0, 122, 250}, nullptr);
+  ui::element_arena arena;
+
+  auto grid = arena.create<ui::grid_layout>(rect(0, 0, 100, 100), &root, 2);
+  auto first = arena.create<ui::button>(rect(0, 0, 80, 30), grid);
+  auto second = arena.create<ui::button>(rect(0, 0, 80, 30), grid);
+  auto third = arena.create<ui::button>(rect(0, 0, 80, 30), grid);
+  root.render_all();
+
+  expect_geometry("first in grid", first, {0, 0, 50, 30});
+  expect_geometry("second in grid", second, {50, 0, 50, 30});
+  expect_geometry("third in grid", third, {0, 30, 50, 30});
+
+  grid->set_padding(2);
+  root.render_all();
+  expect_geometry("first in padded grid", first, {2, 2, 48, 30});
+}
+
+int main() {
+  column_under_root();
+  grid_under_root();
+
+  if (failures)
+    std::cerr << failures << " check(s) failed" << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,206 @@
+// Checks the pattern tiles, and that pattern fills are anchored to the
+// bitmap whichever way they're drawn: translated, anchored to a point of
+// their own, saved and restored, or within a cached layer.
+
+#include <element.h>
+#include <layer_cache.h>
+#include <painter.h>
+
+#include <bit>
+#include <iostream>
+#include <random>
+
+using geometry::point;
+using geometry::rect;
+
+static int failures = 0;
+
+static void expect_same(const char *what, const ui::bitmap &actual,
+                        const ui::bitmap &expected) {
+  if (actual.raw_data() == expected.raw_data())
+    return;
+
+  std::cerr << what << " differs" << std::endl;
+  ++failures;
+}
+
+static bool tile_pixel(const ui::pattern &tile, int x, int y) {
+  return tile.row(y) & (0x80 >> (x & 7));
+}
+
+/**
+ * Every gray level has as many white pixels as its number, including those
+ * of the darker levels.
+ */
+static void gray_levels() {
+  for (int level = 0; level <= ui::pattern::max_gray_level; ++level) {
+    auto tile = ui::pattern::gray(level);
+    int white = 0;
+    for (int y = 0; y < 8; ++y)
+      white += std::popcount(tile.row(y));
+
+    auto darker = ui::pattern::gray(std::max(level - 1, 0));
+    bool nested = true;
+    for (int y = 0; y < 8; ++y)
+      nested = nested && (darker.row(y) & ~tile.row(y)) == 0;
+
+    if (white == level && nested)
+      continue;
+
+    std::cerr << "gray level " << level << " has " << white
+              << " white pixels" << (nested ? "" : " and drops darker ones")
+              << std::endl;
+    ++failures;
+  }
+}
+
+/**
+ * Fill shapes with patterns through a translated painter, either anchored to
+ * the bitmap or to a point of their own, and compare every pixel with the
+ * tile. Restoring the painter has to bring the solid fill back.
+ */
+static void anchored_fills() {
+  std::mt19937 rng(3);
+
+  for (int iteration = 0; iteration < 3000; ++iteration) {
+    geometry::size canvas(1 + rng() % 90, 1 + rng() % 40);
+    int dx = int(rng() % 20) - 10, dy = int(rng() % 20) - 10;
+    auto tile = rng() % 2
+                    ? ui::pattern::gray(rng() % 65)
+                    : ui::pattern::hatching(ui::pattern::hatch(rng() % 6));
+    if (rng() % 3 == 0)
+      tile = tile.inverted();
+
+    bool anchored = rng() % 2;
+    point anchor(int(rng() % 30) - 15, int(rng() % 30) - 15);
+    int kind = rng() % 3;
+    rect r(int(rng() % 100) - 20, int(rng() % 50) - 10, rng() % 60,
+           rng() % 30);
+    uint radius = rng() % 15;
+
+    auto draw_shape = [&](ui::painter &p) {
+      if (kind == 0)
+        p.draw_filled_rect(r);
+      else if (kind == 1)
+        p.draw_filled_circle(r.pos(), radius);
+      else
+        p.draw_filled_rounded_rect(r, radius % 8);
+    };
+
+    ui::bitmap b(canvas);
+    ui::painter p(b);
+    p.translate(dx, dy);
+    p.save();
+    p.set_fill_pattern(tile);
+    if (anchored)
+      p.set_pattern_origin(anchor);
+    draw_shape(p);
+    p.restore();
+    p.draw_filled_rect({-dx, -dy, 3, 3});
+
+    // The same shape in black tells which pixels have been filled.
+    ui::bitmap shape(canvas);
+    ui::painter q(shape);
+    q.translate(dx, dy);
+    draw_shape(q);
+
+    int ax = anchored ? anchor.x() + dx : 0;
+    int ay = anchored ? anchor.y() + dy : 0;
+    bool same = true;
+    for (int y = 0; same && y < canvas.height(); ++y)
+      for (int x = 0; same && x < canvas.width(); ++x) {
+        bool expected = true;
+        if (x < 3 && y < 3)
+          expected = false;
+        else if (!shape.pixel(x, y))
+          expected = tile_pixel(tile, x - ax, y - ay);
+        same = b.pixel(x, y) == expected;
+      }
+
+    if (same)
+      continue;
+
+    std::cerr << "pattern fill differs from the tile in iteration "
+              << iteration << std::endl;
+    ++failures;
+  }
+}
+
+/**
+ * Fills next to each other, drawn through different translations, tile
+ * seamlessly.
+ */
+static void seamless_fills() {
+  ui::bitmap whole(geometry::size(64, 32)), parts(geometry::size(64, 32));
+
+  ui::painter p(whole);
+  p.set_fill_pattern(ui::pattern::gray(20));
+  p.draw_filled_rect({0, 0, 64, 32});
+
+  ui::painter q(parts);
+  q.set_fill_pattern(ui::pattern::gray(20));
+  q.translate(5, 3);
+  q.draw_filled_rect({-5, -3, 21, 32});
+  q.translate(16, 0);
+  q.draw_filled_rect({0, -3, 43, 32});
+
+  expect_same("fill in parts", parts, whole);
+}
+
+/**
+ * Element filled with vertical hatching.
+ */
+class hatched : public ui::element {
+public:
+  using element::element;
+
+protected:
+  void draw(ui::painter &p) override {
+    p.set_fill_pattern(ui::pattern::hatching(ui::pattern::hatch::vertical));
+    p.draw_filled_rect(geometry());
+  }
+};
+
+/**
+ * Render a hatched element within a plain one, then move the plain one so
+ * that the hatched element ends up at another alignment to the tiles.
+ */
+static void render_moved(bool cached, ui::bitmap &before,
+                         ui::bitmap &after) {
+  ui::element root({0, 0, 64, 32}, nullptr);
+  ui::element frame({0, 0, 50, 30}, &root);
+  hatched fill({3, 2, 40, 20}, &frame);
+  fill.set_cached(cached);
+
+  root.render_all();
+  before = root.get_bitmap();
+
+  frame.set_geometry({5, 1, 50, 30});
+  root.render_damage();
+  after = root.get_bitmap();
+
+  if (cached && root.get_layer_cache().used() == 0) {
+    std::cerr << "hatched element hasn't been cached" << std::endl;
+    ++failures;
+  }
+}
+
+static void cached_layers() {
+  ui::bitmap direct_before, direct_after, cached_before, cached_after;
+  render_moved(false, direct_before, direct_after);
+  render_moved(true, cached_before, cached_after);
+
+  expect_same("cached hatching", cached_before, direct_before);
+  expect_same("moved cached hatching", cached_after, direct_after);
+}
+
+int main() {
+  gray_levels();
+  anchored_fills();
+  seamless_fills();
+  cached_layers();
+
+  if (failures)
+    std::cerr << failures << " check(s) failed" << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
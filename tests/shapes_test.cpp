@@ -0,0 +1,209 @@
+// Checks the span based shapes of the painter against a pixel by pixel
+// reference of their definitions, at random positions and sizes which are
+// partly clipped away.
+
+#include <painter.h>
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <numbers>
+#include <random>
+
+using geometry::rect;
+
+static int failures = 0;
+
+static const geometry::size canvas(64, 50);
+static const rect clip_area(3, 2, 50, 40);
+
+/**
+ * Is the pixel within the rectangle? Unlike rect::contains, the right and
+ * bottom edges are outside.
+ */
+static bool within(const rect &r, int x, int y) {
+  auto [left, top] = r.pos().coords();
+  auto [width, height] = r.size().dimensions();
+  return x >= left && y >= top && x < left + width && y < top + height;
+}
+
+/**
+ * Draw the pixels within the clip area for which the predicate holds.
+ */
+static ui::bitmap reference(const std::function<bool(int, int)> &inside) {
+  ui::bitmap b(canvas);
+  for (int y = 0; y < canvas.height(); ++y)
+    for (int x = 0; x < canvas.width(); ++x)
+      if (within(clip_area, x, y) && inside(x, y))
+        b.draw_pixel(x, y, false);
+  return b;
+}
+
+static void expect_same(const char *what, int iteration,
+                        const ui::bitmap &actual, const ui::bitmap &expected) {
+  if (actual.raw_data() == expected.raw_data())
+    return;
+
+  std::cerr << what << " differs from the reference in iteration " << iteration
+            << std::endl;
+  ++failures;
+}
+
+static void check_disc(int iteration, int cx, int cy, int r) {
+  ui::bitmap b(canvas);
+  ui::painter p(b);
+  p.clip(clip_area);
+  p.draw_filled_circle(cx, cy, r);
+
+  expect_same("disc", iteration, b, reference([&](int x, int y) {
+                int dx = x - cx, dy = y - cy;
+                return dx >= -r && dx < r && dy >= -r && dy < r &&
+                       dx * dx + dy * dy < r * r;
+              }));
+}
+
+static void check_ring(int iteration, int cx, int cy, int r, int pen) {
+  ui::bitmap b(canvas);
+  ui::painter p(b);
+  p.clip(clip_area);
+  p.set_point_style(ui::point_style_t::square, pen, false);
+  p.draw_circle_outline({cx, cy}, r);
+
+  int outer = r + pen, inner = std::max(r - pen, 0);
+  expect_same("ring", iteration, b, reference([&](int x, int y) {
+                int dx = x - cx, dy = y - cy, d = dx * dx + dy * dy;
+                return d < outer * outer && d >= inner * inner;
+              }));
+}
+
+static void check_ellipse(int iteration, const rect &r) {
+  ui::bitmap b(canvas);
+  ui::painter p(b);
+  p.clip(clip_area);
+  p.draw_filled_ellipse(r);
+
+  auto [x, y] = r.pos().coords();
+  auto [w, h] = r.size().dimensions();
+  expect_same("ellipse", iteration, b, reference([&](int px, int py) {
+                if (!within(r, px, py))
+                  return false;
+
+                // Distance of the pixel centre from the centre, scaled so
+                // that the ellipse is the unit circle.
+                double u = 2 * (px - x) + 1 - w, v = 2 * (py - y) + 1 - h;
+                return u * u / (double(w) * w) + v * v / (double(h) * h) <=
+                       1 + 1e-12;
+              }));
+}
+
+static void check_rounded_rect(int iteration, const rect &r, int corner) {
+  ui::bitmap b(canvas);
+  ui::painter p(b);
+  p.clip(clip_area);
+  p.draw_filled_rounded_rect(r, corner);
+
+  auto [x, y] = r.pos().coords();
+  auto [w, h] = r.size().dimensions();
+  int c = std::min({corner, w / 2, h / 2});
+  expect_same("rounded rect", iteration, b, reference([&](int px, int py) {
+                if (!within(r, px, py))
+                  return false;
+
+                // Mirror the pixel into the top left corner.
+                int lx = px - x, ly = py - y;
+                if (lx >= w - c)
+                  lx = w - 1 - lx;
+                if (ly >= h - c)
+                  ly = h - 1 - ly;
+                if (lx >= c || ly >= c)
+                  return true;
+
+                int u = 2 * lx + 1 - 2 * c, v = 2 * ly + 1 - 2 * c;
+                return u * u + v * v <= 4 * c * c;
+              }));
+
+  // Without rounding, the outline is the same as a rectangle's.
+  ui::bitmap rounded(canvas), plain(canvas);
+  ui::painter pr(rounded), pp(plain);
+  for (auto q : {&pr, &pp}) {
+    q->clip(clip_area);
+    q->set_point_style(ui::point_style_t::square, 2, false);
+  }
+  pr.draw_rounded_rect_outline(r, 0);
+  pp.draw_rect_outline(r);
+  expect_same("unrounded outline", iteration, rounded, plain);
+}
+
+/**
+ * An arc is a part of the ring: together with the arc covering the rest of
+ * the circle it gives the whole ring, and pixels clearly within or outside
+ * of its angles are drawn or not. Pixels on the border between the two arcs
+ * may be drawn by both, so they're left out.
+ */
+static void check_arc(int iteration, int cx, int cy, int r, int pen, int start,
+                      int end) {
+  auto draw = [&](auto &&how) {
+    ui::bitmap b(canvas);
+    ui::painter p(b);
+    p.clip(clip_area);
+    p.set_point_style(ui::point_style_t::square, pen, false);
+    how(p);
+    return b;
+  };
+  auto arc = draw([&](auto &p) { p.draw_arc({cx, cy}, r, start, end); });
+  auto rest = draw([&](auto &p) { p.draw_arc({cx, cy}, r, end, start); });
+  auto ring = draw([&](auto &p) { p.draw_circle_outline({cx, cy}, r); });
+
+  if (start == end) {
+    expect_same("empty arc", iteration, arc, ui::bitmap(canvas));
+    return;
+  }
+
+  // Black is 0, so the pixels drawn by either are the bitwise and.
+  ui::bitmap both = arc;
+  for (size_t i = 0; i < both.raw_data().size(); ++i)
+    both.raw_data()[i] &= rest.raw_data()[i];
+  expect_same("arc and rest", iteration, both, ring);
+
+  const bool whole = std::abs(end - start) >= 360;
+  const int sweep = ((end - start) % 360 + 360) % 360;
+  expect_same("arc", iteration, arc, reference([&](int x, int y) {
+                if (ring.pixel(x, y))
+                  return false;
+
+                int dx = x - cx, dy = y - cy;
+                if (whole)
+                  return true;
+                if (dx == 0 && dy == 0)
+                  return !arc.pixel(x, y);
+
+                // Counterclockwise from the start, with y pointing up
+                double angle =
+                    std::atan2(-dy, dx) * 180 / std::numbers::pi - start;
+                angle = std::fmod(std::fmod(angle, 360) + 360, 360);
+                if (angle < 1 || angle > 359 || std::abs(angle - sweep) < 1)
+                  return !arc.pixel(x, y);
+                return angle < sweep;
+              }));
+}
+
+int main() {
+  std::mt19937 rng(7);
+  auto random = [&](int n) { return int(rng() % n); };
+
+  for (int iteration = 0; iteration < 2000; ++iteration) {
+    int cx = random(60) - 5, cy = random(50) - 5, r = random(12);
+    int pen = random(4);
+    rect bounds(random(50) - 3, random(40) - 3, random(40), random(30));
+
+    check_disc(iteration, cx, cy, r);
+    check_ring(iteration, cx, cy, r, pen);
+    check_ellipse(iteration, bounds);
+    check_rounded_rect(iteration, bounds, random(10));
+    check_arc(iteration, cx, cy, r, pen, random(720) - 360, random(720) - 360);
+  }
+
+  if (failures)
+    std::cerr << failures << " check(s) failed" << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+// Measures the cost of drawing a whole bitmap into another one with
+// ui::blit, the way layers and icons get composed, at both the same and a
+// different bit alignment.
+
+#include <blit.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[]) {
+  int width = argc > 1 ? std::stoi(argv[1]) : 122;
+  int height = argc > 2 ? std::stoi(argv[2]) : 250;
+  int iterations = argc > 3 ? std::stoi(argv[3]) : 10'000;
+
+  ui::bitmap screen(geometry::size(width, height));
+  ui::bitmap layer(geometry::size(width, height));
+  ui::bitmap mask(geometry::size(width, height));
+  for (size_t i = 0; i < layer.raw_data().size(); ++i) {
+    layer.raw_data()[i] = i * 37;
+    mask.raw_data()[i] = i * 11;
+  }
+
+  auto measure = [&](const geometry::point &to, ui::raster_op op,
+                     const ui::bitmap *m) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+      ui::blit(layer, layer.geometry(), screen, to, op, m);
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    return std::chrono::duration<double, std::micro>(elapsed).count() /
+           iterations;
+  };
+
+  auto copy_us = measure({}, ui::raster_op::copy, nullptr);
+  auto xor_us = measure({}, ui::raster_op::bit_xor, &mask);
+  auto shifted_copy_us = measure({3, 0}, ui::raster_op::copy, nullptr);
+  auto shifted_xor_us = measure({3, 0}, ui::raster_op::bit_xor, &mask);
+
+  // Keep the blits from being optimized away.
+  unsigned checksum = 0;
+  for (auto byte : screen.raw_data())
+    checksum += byte;
+
+  std::cout << "Bitmap: " << width << "x" << height << "\n"
+            << "Copy: " << copy_us << " us\n"
+            << "Masked xor: " << xor_us << " us\n"
+            << "Shifted copy: " << shifted_copy_us << " us\n"
+            << "Shifted masked xor: " << shifted_xor_us << " us\n"
+            << "Checksum: " << checksum << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+// Measures the cost of dispatching an event through a deep element tree.
+// Drag events are used, as no element reacts on them: every element of the
+// tree is visited and nothing gets rendered.
+
+#include <element.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[]) {
+  int depth = argc > 1 ? std::stoi(argv[1]) : 32;
+  int siblings = argc > 2 ? std::stoi(argv[2]) : 4;
+  int iterations = argc > 3 ? std::stoi(argv[3]) : 100'000;
+
+  ui::element root({0, 0, 122, 250}, nullptr);
+  ui::element *parent = &root;
+  int elements = 1;
+
+  for (int level = 0; level < depth; ++level) {
+    auto size = parent->geometry().size();
+    for (int sibling = 0; sibling < siblings; ++sibling, ++elements)
+      new ui::element({0, 0, 1, 1}, parent);
+
+    parent = new ui::element({1, 1, size.width() - 2, size.height() - 2},
+                             parent);
+    ++elements;
+  }
+
+  event ev;
+  ev.type = event::type_t::drag;
+  ev.x = 61;
+  ev.y = 125;
+
+  bool reacted = false;
+  auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+    reacted |= root.process_event(ev);
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+
+  auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  std::cout << "Tree: " << elements << " elements, depth " << depth << "\n"
+            << "Dispatch: " << ns / iterations << " ns/event, "
+            << ns / iterations / elements << " ns/element"
+            << (reacted ? " (some element reacted!)" : "") << std::endl;
+
+  return EXIT_SUCCESS;
+}
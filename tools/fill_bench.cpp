@@ -0,0 +1,52 @@
+// Measures the cost of filling a whole bitmap with painter::draw_filled_rect,
+// which every element does to draw its background, in solid colors and with
+// a dither pattern.
+
+#include <painter.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[]) {
+  int width = argc > 1 ? std::stoi(argv[1]) : 122;
+  int height = argc > 2 ? std::stoi(argv[2]) : 250;
+  int iterations = argc > 3 ? std::stoi(argv[3]) : 10'000;
+
+  ui::bitmap screen(geometry::size(width, height));
+  ui::painter p(screen);
+
+  // Odd offsets make for partial bytes at both ends of every row.
+  const geometry::rect whole = screen.geometry();
+  const geometry::rect unaligned(3, 1, width - 6, height - 2);
+
+  auto measure = [&](const geometry::rect &area) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      p.set_point_style(ui::point_style_t::square, 1, i & 1);
+      p.draw_filled_rect(area);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+    return std::chrono::duration<double, std::micro>(elapsed).count() /
+           iterations;
+  };
+
+  auto aligned_us = measure(whole);
+  auto unaligned_us = measure(unaligned);
+
+  p.set_fill_pattern(ui::pattern::gray(ui::pattern::max_gray_level / 2));
+  auto dithered_us = measure(unaligned);
+
+  // Keep the fills from being optimized away.
+  unsigned checksum = 0;
+  for (auto byte : screen.raw_data())
+    checksum += byte;
+
+  std::cout << "Bitmap: " << width << "x" << height << "\n"
+            << "Full fill: " << aligned_us << " us\n"
+            << "Unaligned fill: " << unaligned_us << " us\n"
+            << "Unaligned dithered fill: " << dithered_us << " us\n"
+            << "Checksum: " << checksum << std::endl;
+
+  return EXIT_SUCCESS;
+}
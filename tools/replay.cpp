@@ -0,0 +1,178 @@
+// Replays a touch session recorded by "einktouch --record <file>" through the
+// UI event dispatch and rendering, and reports throughput and latency. Does
+// not need any hardware, so it runs on any Linux box.
+
+#include <button.h>
+#include <coalescer.h>
+#include <element_arena.h>
+#include <filter.h>
+#include <layout.h>
+#include <recording.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+static void usage(const char *name) {
+  std::cerr << "Usage: " << name
+            << " <recording> [--fast] [--filter] [--coalesce] [--repeat N]\n"
+               "  --fast      replay as fast as possible instead of the "
+               "original pace\n"
+               "  --filter    pass events through the touch jitter filter\n"
+               "  --coalesce  coalesce drag events of each recorded batch\n"
+               "  --repeat N  replay the recording N times\n";
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto pace = recording::player::pace_t::original;
+  bool filter_jitter = false;
+  bool coalesce_drags = false;
+  int repeat = 1;
+
+  for (int arg = 2; arg < argc; ++arg) {
+    std::string option = argv[arg];
+
+    if (option == "--fast")
+      pace = recording::player::pace_t::fast;
+    else if (option == "--filter")
+      filter_jitter = true;
+    else if (option == "--coalesce")
+      coalesce_drags = true;
+    else if (option == "--repeat" && arg + 1 < argc)
+      repeat = std::max(1, std::stoi(argv[++arg]));
+    else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  recording::player player(argv[1]);
+
+  // The same screen main.cpp shows on the 122x250 panel.
+  ui::element root({0, 0, 121, 249}, nullptr);
+  ui::element_arena screen;
+  using geometry::rect;
+
+  const int gap = 10;
+  const rect button_size(0, 0, 80, 30);
+  const uint corner_radius = 6;
+
+  auto add_button = [&](ui::element *panel) {
+    auto b = screen.create<ui::button>(button_size, panel);
+    b->set_corner_radius(corner_radius);
+    return b;
+  };
+
+  auto panels = screen.create<ui::column_layout>(root.geometry(), &root);
+  panels->set_padding(gap);
+  panels->set_spacing(gap);
+
+  auto s1 = screen.create<ui::column_layout>(rect(), panels);
+  s1->set_padding(gap);
+  s1->set_spacing(gap);
+  add_button(s1)->set_toggleable(true);
+  add_button(s1)->set_toggleable(true);
+
+  auto s2 = screen.create<ui::column_layout>(rect(), panels);
+  s2->set_padding(gap);
+  s2->set_spacing(gap);
+  for (int i = 0; i < 3; ++i)
+    add_button(s2);
+
+  root.render_all();
+
+  touch_filter jitter_filter;
+  touch_coalescer coalescer;
+
+  size_t dispatched = 0;
+  size_t presented = 0;
+  std::vector<clock_type::duration> latencies;
+  latencies.reserve(player.frames().size() * repeat);
+
+  auto sink = [&](const std::vector<event> &recorded) {
+    auto begin = clock_type::now();
+    auto events = filter_jitter ? jitter_filter.filter(recorded) : recorded;
+
+    if (coalesce_drags) {
+      coalescer.push(events);
+      events = coalescer.take();
+    }
+
+    bool need_update = false;
+    for (const auto &ev : events)
+      if (root.process_event(ev))
+        need_update = true;
+    dispatched += events.size();
+
+    if (need_update) {
+      // That's what the display driver gets in main.cpp, see
+      // waveshare_eink::put_region
+      auto damage = root.render_damage();
+      auto rows = root.geometry();
+      rows.set_position(0, damage.pos().y());
+      rows.set_size(rows.size().width(), damage.size().height());
+
+      if (damage.area() > 0) {
+        ui::bitmap frame = root.get_bitmap().cropped(rows);
+        ++presented;
+      }
+    }
+
+    latencies.emplace_back(clock_type::now() - begin);
+  };
+
+  auto begin = clock_type::now();
+  for (int pass = 0; pass < repeat; ++pass)
+    player.play(sink, pace);
+  auto elapsed = clock_type::now() - begin;
+
+  using us = std::chrono::duration<double, std::micro>;
+  auto seconds = std::chrono::duration<double>(elapsed).count();
+
+  std::cout << "Recorded: " << player.event_count() << " events in "
+            << std::chrono::duration<double>(player.duration()).count()
+            << " s\n"
+            << "Replayed: " << latencies.size() << " batches, " << dispatched
+            << " events dispatched, " << presented << " frames presented in "
+            << seconds << " s\n";
+
+  if (seconds > 0)
+    std::cout << "Throughput: " << dispatched / seconds << " events/s\n";
+
+  if (filter_jitter) {
+    auto stats = jitter_filter.get_statistics();
+    std::cout << "Touch filter suppressed " << stats.suppressed()
+              << " events\n";
+  }
+
+  if (coalesce_drags)
+    std::cout << "Coalescer merged " << coalescer.merged() << " events\n";
+
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+      auto idx = static_cast<size_t>(p * (latencies.size() - 1));
+      return us(latencies[idx]).count();
+    };
+
+    clock_type::duration total{};
+    for (auto l : latencies)
+      total += l;
+
+    std::cout << "Batch latency, us: min " << percentile(0) << ", avg "
+              << us(total).count() / latencies.size() << ", p50 "
+              << percentile(0.5) << ", p99 " << percentile(0.99) << ", max "
+              << percentile(1) << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
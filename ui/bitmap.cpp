@@ -1,9 +1,15 @@
 #include "bitmap.h"
 
+#include "blit.h"
 #include "bmp_image.h"
+#include "pattern.h"
+#include "span.h"
 
 #include <math_util.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace ui {
 
 bitmap::bitmap(const vect &data, const size s)
@@ -26,68 +32,134 @@ uint bitmap::bytes_per_row() const {
   return div_ceil(m_geometry.size().width(), 8);
 }
 
-bool bitmap::pixel(const point &p) const {
-  auto byte_bit = std::div(p.x(), 8);
-  auto idx = div_ceil(m_geometry.size().width(), 8) * p.y() + byte_bit.quot;
-  if (idx < 0 || idx >= m_data.size())
-    throw std::out_of_range("Pixel out of bitmap bounds");
-
-  return m_data[idx] & (0x80 >> byte_bit.rem);
-}
+bool bitmap::pixel(const point &p) const { return pixel(p.x(), p.y()); }
 
 bool bitmap::pixel(uint x, uint y) const {
-  auto byte_bit = std::div(x, 8);
-  auto idx = div_ceil(m_geometry.size().width(), 8) * y + byte_bit.quot;
-  if (idx < 0 || idx >= m_data.size())
+  if (!within(x, y))
     throw std::out_of_range("Pixel out of bitmap bounds");
 
-  return m_data[idx] & (0x80 >> byte_bit.rem);
+  return pixel_unchecked(x, y);
 }
 
 void bitmap::draw_pixel(const point &p, bool white) {
-  auto byte_bit = std::div(p.x(), 8);
-  auto idx = div_ceil(m_geometry.size().width(), 8) * p.y() + byte_bit.quot;
-  if (idx < 0 || idx >= m_data.size())
-    throw std::out_of_range("Pixel out of bitmap bounds");
-
-  if (white)
-    m_data[idx] |= (0x80 >> byte_bit.rem);
-  else
-    m_data[idx] &= ~(0x80 >> byte_bit.rem);
+  draw_pixel(p.x(), p.y(), white);
 }
 
 void bitmap::draw_pixel(uint x, uint y, bool white) {
-  auto byte_bit = std::div(x, 8);
-  auto idx = div_ceil(m_geometry.size().width(), 8) * y + byte_bit.quot;
-  if (idx < 0 || idx >= m_data.size())
+  if (!within(x, y))
     throw std::out_of_range("Pixel out of bitmap bounds");
 
-  if (white)
-    m_data[idx] |= (0x80 >> byte_bit.rem);
-  else
-    m_data[idx] &= ~(0x80 >> byte_bit.rem);
+  draw_pixel_unchecked(x, y, white);
+}
+
+void bitmap::fill(const rect &area, uint8_t pattern) {
+  auto bounds = m_geometry.overlap(area);
+  auto [width, height] = bounds.size().dimensions();
+  if (width <= 0 || height <= 0)
+    return;
+
+  auto [min_x, min_y] = bounds.pos().coords();
+  for (int y = min_y; y < min_y + height; ++y)
+    fill_span(row_unchecked(y), min_x, min_x + width, pattern);
+}
+
+void bitmap::fill(const rect &area, const ui::pattern &tile) {
+  auto bounds = m_geometry.overlap(area);
+  auto [width, height] = bounds.size().dimensions();
+  if (width <= 0 || height <= 0)
+    return;
+
+  auto [min_x, min_y] = bounds.pos().coords();
+  for (int y = min_y; y < min_y + height; ++y)
+    fill_span(row_unchecked(y), min_x, min_x + width, tile.row(y));
 }
 
 void bitmap::crop(const rect &area) { *this = cropped(area); }
 
 bitmap bitmap::cropped(const rect &area) const {
-  bitmap result;
+  auto bounds = m_geometry.overlap(area);
+  bounds.normalize();
+
+  bitmap result(bounds.size());
+  blit(*this, bounds, result, {});
+  return result;
+}
+
+void bitmap::copy(const bitmap &src, const rect &src_area, const point &to) {
+  blit(src, src_area, *this, to);
+}
 
-  result.m_geometry = m_geometry.overlap(area);
-  result.m_geometry.normalize();
-  auto size = result.m_geometry.size();
-  result.m_data.resize(bytes_per_row() * size.height(), 0xff);
+void bitmap::scroll(const rect &area, int dy) {
+  auto shifted = m_geometry.overlap(area);
+  auto [width, height] = shifted.size().dimensions();
+  if (width <= 0 || dy == 0 || std::abs(dy) >= height)
+    return;
+
+  const int row_bytes = bytes_per_row();
+  const int rows = height - std::abs(dy);
+  const int src_y = shifted.pos().y() + std::max(0, -dy);
+  const int dst_y = shifted.pos().y() + std::max(0, dy);
+
+  if (width == m_geometry.size().width()) {
+    // Whole rows, which are stored contiguously.
+    std::memmove(m_data.data() + dst_y * row_bytes,
+                 m_data.data() + src_y * row_bytes, rows * row_bytes);
+    return;
+  }
+
+  // The pixels stay within their columns, so only the bytes at the edges of
+  // the area have to be merged.
+  const int min_x = shifted.pos().x();
+  const int max_x = min_x + width - 1;
+  const int first = min_x >> 3;
+  const int last = max_x >> 3;
+  uint8_t first_mask = 0xff >> (min_x & 7);
+  uint8_t last_mask = 0xff << (7 - (max_x & 7));
+  if (first == last)
+    first_mask = last_mask = first_mask & last_mask;
+
+  auto merge = [](uint8_t &d, uint8_t s, uint8_t mask) {
+    d = (d & ~mask) | (s & mask);
+  };
+
+  // Rows are moved away from the direction of the shift first, so that none
+  // is overwritten before it's been moved.
+  for (int i = 0; i < rows; ++i) {
+    int row = dy > 0 ? rows - 1 - i : i;
+    auto s = m_data.data() + (src_y + row) * row_bytes;
+    auto d = m_data.data() + (dst_y + row) * row_bytes;
+
+    merge(d[first], s[first], first_mask);
+    if (last > first) {
+      std::memcpy(d + first + 1, s + first + 1, last - first - 1);
+      merge(d[last], s[last], last_mask);
+    }
+  }
+}
 
-  auto [min_x, min_y] = result.m_geometry.top_left().coords();
-  auto [max_x, max_y] = result.m_geometry.bottom_right().coords();
+geometry::rect bitmap::changed_rows(const bitmap &other) const {
+  if (other.m_geometry.size() != m_geometry.size())
+    return m_geometry;
 
-  for (int src_y = min_y, dst_y = 0; src_y < max_y; ++src_y, ++dst_y)
-    for (int src_x = min_x, dst_x = 0; src_x < max_x; ++src_x, ++dst_x)
-      result.draw_pixel(dst_x, dst_y, pixel(src_x, src_y));
+  const int row_bytes = bytes_per_row();
+  const int height = m_geometry.size().height();
+  auto row_differs = [&](int y) {
+    return std::memcmp(m_data.data() + y * row_bytes,
+                       other.m_data.data() + y * row_bytes, row_bytes) != 0;
+  };
 
-  result.m_geometry.set_position(0, 0);
+  int first = 0;
+  while (first < height && !row_differs(first))
+    ++first;
 
-  return result;
+  if (first == height)
+    return {};
+
+  int last = height - 1;
+  while (!row_differs(last))
+    --last;
+
+  return rect(0, first, m_geometry.size().width(), last - first + 1);
 }
 
 } // namespace ui
@@ -3,9 +3,12 @@
 #include <byte_util.h>
 #include <rect.h>
 
+#include <stdexcept>
+
 namespace ui {
 
 class bmp_image;
+class pattern;
 
 /**
  * @brief The bitmap class - a class representing monochrome images (with 1 bit
@@ -22,6 +25,9 @@ private:
   vect m_data;
   rect m_geometry;
 
+  bool within(int x, int y) const;
+  void check_unchecked(int x, int y) const;
+
 public:
   bitmap() = default;
 
@@ -40,8 +46,92 @@ public:
   void draw_pixel(const point &p, bool white = false);
   void draw_pixel(uint x, uint y, bool white = false);
 
+  /**
+   * Get the bytes_per_row() bytes of a row, for loops which have been
+   * clipped to the bitmap up front. Like the other *_unchecked accessors,
+   * it's only checked in debug builds.
+   */
+  uint8_t *row_unchecked(int y);
+  const uint8_t *row_unchecked(int y) const;
+
+  bool pixel_unchecked(int x, int y) const;
+  void draw_pixel_unchecked(int x, int y, bool white = false);
+
+  /**
+   * Fill an area with a byte repeated along the rows, see ui::fill_span.
+   * @param area area to fill; trimmed to the bitmap
+   * @param pattern 0x00 for black, 0xff for white
+   */
+  void fill(const rect &area, uint8_t pattern);
+
+  /**
+   * Fill an area with a pattern anchored to the top left corner.
+   * @param area area to fill; trimmed to the bitmap
+   */
+  void fill(const rect &area, const ui::pattern &tile);
+
   void crop(const rect &area);
   bitmap cropped(const rect &area) const;
+
+  /**
+   * Copy an area of another bitmap into this one.
+   * @param src bitmap to copy from
+   * @param src_area area of src to copy; trimmed to both bitmaps
+   * @param to top left corner of the copy in this bitmap
+   */
+  void copy(const bitmap &src, const rect &src_area, const point &to);
+
+  /**
+   * Shift the rows of an area vertically within the area. Rows shifted out
+   * are lost, and the uncovered ones keep their pixels.
+   * @param area area to shift; trimmed to the bitmap
+   * @param dy rows to shift by, positive to shift down
+   */
+  void scroll(const rect &area, int dy);
+
+  /**
+   * Get the rows which differ from another bitmap.
+   * @return full width band from the first to the last differing row; zero
+   * sized if the bitmaps are the same, the whole bitmap if their sizes differ
+   */
+  rect changed_rows(const bitmap &other) const;
 };
 
+inline bool bitmap::within(int x, int y) const {
+  auto [width, height] = m_geometry.size().dimensions();
+  return x >= 0 && x < width && y >= 0 && y < height;
+}
+
+inline void bitmap::check_unchecked([[maybe_unused]] int x,
+                                    [[maybe_unused]] int y) const {
+#ifndef NDEBUG
+  if (!within(x, y))
+    throw std::out_of_range("Unchecked access out of bitmap bounds");
+#endif
+}
+
+inline uint8_t *bitmap::row_unchecked(int y) {
+  check_unchecked(0, y);
+  return m_data.data() + y * bytes_per_row();
+}
+
+inline const uint8_t *bitmap::row_unchecked(int y) const {
+  check_unchecked(0, y);
+  return m_data.data() + y * bytes_per_row();
+}
+
+inline bool bitmap::pixel_unchecked(int x, int y) const {
+  check_unchecked(x, y);
+  return row_unchecked(y)[x >> 3] & (0x80 >> (x & 7));
+}
+
+inline void bitmap::draw_pixel_unchecked(int x, int y, bool white) {
+  check_unchecked(x, y);
+  auto &byte = row_unchecked(y)[x >> 3];
+  if (white)
+    byte |= 0x80 >> (x & 7);
+  else
+    byte &= ~(0x80 >> (x & 7));
+}
+
 } // namespace ui
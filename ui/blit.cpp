@@ -0,0 +1,339 @@
+#include "blit.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ui {
+
+using geometry::point;
+using geometry::rect;
+
+template <raster_op op, typename T> static T combine(T d, T s) {
+  if constexpr (op == raster_op::copy)
+    return s;
+  else if constexpr (op == raster_op::bit_or)
+    return d | s;
+  else if constexpr (op == raster_op::bit_and)
+    return d & s;
+  else if constexpr (op == raster_op::bit_xor)
+    return d ^ s;
+  else if constexpr (op == raster_op::and_not)
+    return d & T(~s);
+  else
+    return T(~s);
+}
+
+template <typename T> static T merge(T d, T value, T mask) {
+  return (d & T(~mask)) | (value & mask);
+}
+
+#if defined(__SSE2__)
+using block = __m128i;
+
+static block load_block(const uint8_t *p) {
+  return _mm_loadu_si128(reinterpret_cast<const block *>(p));
+}
+
+static void store_block(uint8_t *p, block b) {
+  _mm_storeu_si128(reinterpret_cast<block *>(p), b);
+}
+
+template <raster_op op> static block combine_block(block d, block s) {
+  if constexpr (op == raster_op::copy)
+    return s;
+  else if constexpr (op == raster_op::bit_or)
+    return _mm_or_si128(d, s);
+  else if constexpr (op == raster_op::bit_and)
+    return _mm_and_si128(d, s);
+  else if constexpr (op == raster_op::bit_xor)
+    return _mm_xor_si128(d, s);
+  else if constexpr (op == raster_op::and_not)
+    return _mm_andnot_si128(s, d);
+  else
+    return _mm_xor_si128(s, _mm_set1_epi8(-1));
+}
+
+static block merge_block(block d, block value, block mask) {
+  return _mm_or_si128(_mm_andnot_si128(mask, d), _mm_and_si128(value, mask));
+}
+#elif defined(__ARM_NEON)
+using block = uint8x16_t;
+
+static block load_block(const uint8_t *p) { return vld1q_u8(p); }
+static void store_block(uint8_t *p, block b) { vst1q_u8(p, b); }
+
+template <raster_op op> static block combine_block(block d, block s) {
+  if constexpr (op == raster_op::copy)
+    return s;
+  else if constexpr (op == raster_op::bit_or)
+    return vorrq_u8(d, s);
+  else if constexpr (op == raster_op::bit_and)
+    return vandq_u8(d, s);
+  else if constexpr (op == raster_op::bit_xor)
+    return veorq_u8(d, s);
+  else if constexpr (op == raster_op::and_not)
+    return vbicq_u8(d, s);
+  else
+    return vmvnq_u8(s);
+}
+
+static block merge_block(block d, block value, block mask) {
+  return vbslq_u8(mask, value, d);
+}
+#endif
+
+// Whole bytes of rows with the same bit alignment; bitwise operations don't
+// care about the order of the bits, so they go 16 or 8 bytes at once.
+template <raster_op op>
+static void combine_bytes(uint8_t *d, const uint8_t *s, const uint8_t *m,
+                          int count) {
+  if (op == raster_op::copy && !m) {
+    std::memmove(d, s, count);
+    return;
+  }
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+  for (; count >= 16; count -= 16, d += 16, s += 16) {
+    auto value = combine_block<op>(load_block(d), load_block(s));
+    if (m) {
+      value = merge_block(load_block(d), value, load_block(m));
+      m += 16;
+    }
+    store_block(d, value);
+  }
+#endif
+
+  for (; count >= 8; count -= 8, d += 8, s += 8) {
+    uint64_t dw, sw;
+    std::memcpy(&dw, d, 8);
+    std::memcpy(&sw, s, 8);
+    auto value = combine<op>(dw, sw);
+    if (m) {
+      uint64_t mw;
+      std::memcpy(&mw, m, 8);
+      value = merge(dw, value, mw);
+      m += 8;
+    }
+    std::memcpy(d, &value, 8);
+  }
+
+  for (; count > 0; --count, ++d, ++s) {
+    auto value = combine<op>(*d, *s);
+    *d = m ? merge(*d, value, *m++) : value;
+  }
+}
+
+// Rows with the same bit alignment: the bytes at the ends are merged with
+// the edge masks, the ones in between are combined whole.
+template <raster_op op>
+static void blit_aligned_row(const uint8_t *src, int src_x, uint8_t *dst,
+                             int dst_x, int width, const uint8_t *mask) {
+  const int end_x = dst_x + width;
+  int first = dst_x >> 3;
+  int last = (end_x - 1) >> 3;
+  const int src_offset = (src_x >> 3) - first;
+  const uint8_t first_mask = 0xff >> (dst_x & 7);
+  const uint8_t last_mask = 0xff << (7 - ((end_x - 1) & 7));
+
+  auto edge = [&](int byte, uint8_t edge_mask) {
+    auto s = src[byte + src_offset];
+    if (mask)
+      edge_mask &= mask[byte + src_offset];
+    dst[byte] = merge(dst[byte], combine<op>(dst[byte], s), edge_mask);
+  };
+
+  if (first == last) {
+    edge(first, first_mask & last_mask);
+    return;
+  }
+
+  if (first_mask != 0xff)
+    edge(first++, first_mask);
+  if (last_mask != 0xff)
+    edge(last--, last_mask);
+
+  if (first <= last)
+    combine_bytes<op>(dst + first, src + first + src_offset,
+                      mask ? mask + first + src_offset : nullptr,
+                      last - first + 1);
+}
+
+// The first count bytes of a word, the first byte being the most significant
+// one, as pixels are stored.
+static uint64_t load_word(const uint8_t *p, int count) {
+  uint64_t word = 0;
+  for (int i = 0; i < count; ++i)
+    word |= uint64_t(p[i]) << (56 - 8 * i);
+  return word;
+}
+
+static void store_word(uint8_t *p, uint64_t word, int count) {
+  for (int i = 0; i < count; ++i)
+    p[i] = word >> (56 - 8 * i);
+}
+
+static uint64_t load_full_word(const uint8_t *p) {
+  uint64_t word;
+  std::memcpy(&word, p, sizeof(word));
+  if constexpr (std::endian::native == std::endian::little)
+    bytes::byteswap(word);
+  return word;
+}
+
+static void store_full_word(uint8_t *p, uint64_t word) {
+  if constexpr (std::endian::native == std::endian::little)
+    bytes::byteswap(word);
+  std::memcpy(p, &word, sizeof(word));
+}
+
+// Bytes [byte, byte + 8) of a row as a word; the ones outside of the row
+// are 0.
+static uint64_t load_source(const uint8_t *row, int row_bytes, int byte) {
+  if (byte >= 0 && byte + 8 <= row_bytes)
+    return load_full_word(row + byte);
+
+  uint64_t word = 0;
+  for (int i = std::max(0, -byte); i < 8 && byte + i < row_bytes; ++i)
+    word |= uint64_t(row[byte + i]) << (56 - 8 * i);
+  return word;
+}
+
+// Rows with different bit alignments: a destination word at once. Source
+// words are loaded once each, and every pair of neighbouring ones is joined
+// with a funnel shift into the pixels of a destination word.
+template <raster_op op>
+static void blit_shifted_row(const uint8_t *src, int src_bytes, int src_x,
+                             uint8_t *dst, int dst_x, int width,
+                             const uint8_t *mask) {
+  const int end_x = dst_x + width;
+  const int first_x = dst_x & ~7;
+  const int from = src_x - dst_x + first_x;
+  const int shift = from & 7; // not 0, or the row would be aligned
+  int byte = from >> 3;
+
+  auto next = load_source(src, src_bytes, byte);
+  auto next_mask = mask ? load_source(mask, src_bytes, byte) : 0;
+  auto funnel = [shift](uint64_t high, uint64_t low) {
+    return (high << shift) | (low >> (64 - shift));
+  };
+
+  for (int x = first_x; x < end_x; x += 64) {
+    byte += 8;
+    auto s = next;
+    next = load_source(src, src_bytes, byte);
+    s = funnel(s, next);
+
+    uint64_t word_mask = ~0ull;
+    if (x < dst_x)
+      word_mask >>= dst_x - x;
+    if (end_x - x < 64)
+      word_mask &= ~(~0ull >> (end_x - x));
+    if (mask) {
+      auto m = next_mask;
+      next_mask = load_source(mask, src_bytes, byte);
+      word_mask &= funnel(m, next_mask);
+    }
+
+    auto d = dst + (x >> 3);
+    const int count = std::min(8, (end_x - x + 7) >> 3);
+    if (op == raster_op::copy && word_mask == ~0ull) {
+      store_full_word(d, s);
+      continue;
+    }
+
+    auto dw = count == 8 ? load_full_word(d) : load_word(d, count);
+    dw = merge(dw, combine<op>(dw, s), word_mask);
+
+    if (count == 8)
+      store_full_word(d, dw);
+    else
+      store_word(d, dw, count);
+  }
+}
+
+template <raster_op op>
+static void blit_rows(const bitmap &src, const rect &from, bitmap &dst,
+                      const rect &to, const bitmap *mask) {
+  auto [width, height] = to.size().dimensions();
+  const int src_x = from.pos().x();
+  const int dst_x = to.pos().x();
+  const int src_bytes = src.bytes_per_row();
+  const bool aligned = ((src_x - dst_x) & 7) == 0;
+
+  for (int row = 0; row < height; ++row) {
+    const int src_y = from.pos().y() + row;
+    auto s = src.row_unchecked(src_y);
+    auto d = dst.row_unchecked(to.pos().y() + row);
+    auto m = mask ? mask->row_unchecked(src_y) : nullptr;
+
+    if (aligned)
+      blit_aligned_row<op>(s, src_x, d, dst_x, width, m);
+    else
+      blit_shifted_row<op>(s, src_bytes, src_x, d, dst_x, width, m);
+  }
+}
+
+void blit(const bitmap &src, const rect &src_area, bitmap &dst,
+          const point &to, raster_op op, const bitmap *mask) {
+  if (mask && mask->geometry().size() != src.geometry().size())
+    throw std::invalid_argument("Blit mask has to be of the source size");
+
+  // Trim the area to the source, then the destination to the target, and
+  // carry the trimming over to the other side.
+  auto offset = to - src_area.pos();
+  auto target = src.geometry().overlap(src_area);
+  target.move(offset.x(), offset.y());
+  target = dst.geometry().overlap(target);
+
+  auto from = target;
+  from.move(-offset.x(), -offset.y());
+
+  auto [width, height] = target.size().dimensions();
+  if (width <= 0 || height <= 0)
+    return;
+
+  // Rows are combined in place, so an overlapping source is copied first.
+  if ((&src == &dst || mask == &dst) && from.intersects(target)) {
+    auto copy = src.cropped(from);
+    if (!mask)
+      return blit(copy, copy.geometry(), dst, target.pos(), op);
+
+    auto mask_copy = mask->cropped(from);
+    return blit(copy, copy.geometry(), dst, target.pos(), op, &mask_copy);
+  }
+
+  // Whole rows, which are stored contiguously.
+  const int row_bytes = src.bytes_per_row();
+  if (op == raster_op::copy && !mask && from.pos().x() == 0 &&
+      target.pos().x() == 0 && width == src.geometry().size().width() &&
+      width == dst.geometry().size().width()) {
+    std::memmove(dst.row_unchecked(target.pos().y()),
+                 src.row_unchecked(from.pos().y()), height * row_bytes);
+    return;
+  }
+
+  switch (op) {
+  case raster_op::copy:
+    return blit_rows<raster_op::copy>(src, from, dst, target, mask);
+  case raster_op::bit_or:
+    return blit_rows<raster_op::bit_or>(src, from, dst, target, mask);
+  case raster_op::bit_and:
+    return blit_rows<raster_op::bit_and>(src, from, dst, target, mask);
+  case raster_op::bit_xor:
+    return blit_rows<raster_op::bit_xor>(src, from, dst, target, mask);
+  case raster_op::and_not:
+    return blit_rows<raster_op::and_not>(src, from, dst, target, mask);
+  case raster_op::invert:
+    return blit_rows<raster_op::invert>(src, from, dst, target, mask);
+  }
+}
+
+} // namespace ui
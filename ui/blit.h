@@ -0,0 +1,33 @@
+#pragma once
+
+#include "bitmap.h"
+
+namespace ui {
+
+/**
+ * How source pixels are combined with the destination ones by ui::blit, bit
+ * by bit; set bits are white.
+ */
+enum class raster_op {
+  copy,    // source
+  bit_or,  // destination | source: only white source pixels show
+  bit_and, // destination & source: only black source pixels show
+  bit_xor, // destination ^ source: white source pixels invert
+  and_not, // destination & ~source: white source pixels turn black
+  invert,  // ~source
+};
+
+/**
+ * Combine an area of one bitmap with another one at any bit alignment.
+ * @param src bitmap to take the pixels from; may be the destination too
+ * @param src_area area of src; trimmed to both bitmaps
+ * @param dst bitmap to draw into
+ * @param to top left corner of the area in dst
+ * @param mask bitmap of the size of src; only pixels where it's white are
+ * drawn, if given
+ */
+void blit(const bitmap &src, const geometry::rect &src_area, bitmap &dst,
+          const geometry::point &to, raster_op op = raster_op::copy,
+          const bitmap *mask = nullptr);
+
+} // namespace ui
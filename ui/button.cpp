@@ -1,18 +1,36 @@
 #include "button.h"
 
+#include <algorithm>
+
 namespace ui {
 
-void button::draw() {
-  element::draw();
+void button::draw(painter &p) {
+  const int radius = m_corner_radius;
+
+  if (radius == 0)
+    element::draw(p);
+  else {
+    // The same border as element::draw draws, following the corners.
+    auto inside = geometry();
+    inside.move(3, 3);
+    inside.resize(-6, -6);
+
+    p.set_point_style(point_style_t::square, 1, false);
+    p.draw_filled_rounded_rect(geometry(), radius);
+
+    p.set_point_style(point_style_t::square, 1, true);
+    p.draw_filled_rounded_rect(inside, std::max(radius - 3, 0));
+
+    p.set_point_style(point_style_t::square, 1, false);
+  }
 
   if (m_toggleable && m_toggled) {
-    auto p = get_painter();
     auto g = geometry();
 
     g.move(5, 5);
     g.resize(-10, -10);
 
-    p->draw_filled_rect(g);
+    p.draw_filled_rounded_rect(g, std::max(radius - 5, 0));
   }
 }
 
@@ -51,24 +69,40 @@ button::button(geometry::rect &&relative_geometry, element *superelement)
 
 button::~button() {}
 
+uint64_t button::visual_state() const { return m_toggleable && m_toggled; }
+
+bool button::opaque() const { return m_corner_radius == 0; }
+
 bool button::toggleable() const { return m_toggleable; }
 
 bool button::toggled() const { return m_toggled; }
 
 void button::set_toggleable(bool toggleable) {
   m_toggleable = toggleable;
-  if (!m_toggleable)
+  if (!m_toggleable && m_toggled) {
     m_toggled = false;
+    invalidate();
+  }
 }
 
 void button::set_toggled(bool toggled) {
-  if (!m_toggleable)
+  if (!m_toggleable || toggled == m_toggled)
     return;
 
   m_toggled = toggled;
-  draw();
+  invalidate();
 }
 
+void button::set_corner_radius(uint radius) {
+  if (radius == m_corner_radius)
+    return;
+
+  m_corner_radius = radius;
+  invalidate();
+}
+
+uint button::corner_radius() const { return m_corner_radius; }
+
 void button::set_clicked_callback(std::function<void(void)> func) {
   m_on_clicked_callback = func;
 }
@@ -3,19 +3,22 @@
 
 namespace ui {
 
-class button : protected element {
+class button : public element {
   using rect = geometry::rect;
 
   bool m_toggleable = false;
   bool m_toggled = false;
   bool m_waiting_for_release = false;
+  uint m_corner_radius = 0;
 
   std::function<void(void)> m_on_clicked_callback;
   std::function<void(bool)> m_on_toggled_callback;
 
 protected:
-  virtual void draw();
+  virtual void draw(painter &p);
   virtual bool on_touch_event(const event &ev);
+  virtual uint64_t visual_state() const;
+  virtual bool opaque() const;
 
 public:
   button(const rect &relative_geometry, element *superelement = nullptr);
@@ -28,6 +31,12 @@ public:
   void set_toggleable(bool);
   void set_toggled(bool);
 
+  /**
+   * Round the corners off; whatever is behind the button shows through them.
+   */
+  void set_corner_radius(uint radius);
+  uint corner_radius() const;
+
   void set_clicked_callback(std::function<void(void)> func);
   void set_toggled_callback(std::function<void(bool)> &&func);
 };
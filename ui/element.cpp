@@ -1,27 +1,104 @@
 #include "element.h"
+#include "element_arena.h"
+#include "hit_index.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Past that many separate damage areas they are merged into one; the
+// elements intersecting all of them would be checked for each one otherwise.
+static const size_t max_damage_areas = 8;
 
 namespace ui {
 
 element::element(const rect &relative_geometry, element *superelement)
-    : m_relative_geometry(relative_geometry), m_superelement(superelement) {
-
-  if (m_superelement)
-    m_superelement->m_subelements.emplace_back(this);
-  else
-    m_bitmap.reset(new bitmap(relative_geometry.size()));
+    : m_relative_geometry(relative_geometry), m_superelement(superelement),
+      m_preferred_size(relative_geometry.size()) {
+  attach();
 }
 
 element::element(rect &&relative_geometry, element *superelement)
-    : m_relative_geometry(relative_geometry), m_superelement(superelement) {
+    : m_relative_geometry(relative_geometry), m_superelement(superelement),
+      m_preferred_size(m_relative_geometry.size()) {
+  attach();
+}
+
+element::~element() {
+  if (m_arena && m_arena->m_tearing_down)
+    return; // already released by the arena, see element::release_from_arena
+
+  // Subelements remove themselves from the list, so iterate over a copy.
+  auto subelements = std::move(m_subelements);
+  for (auto e : subelements)
+    if (!e->m_arena)
+      delete e;
+
   if (m_superelement)
+    detach();
+}
+
+void element::attach() {
+  m_arena = std::exchange(element_arena::s_constructing, nullptr);
+  m_root = m_superelement ? m_superelement->m_root : this;
+
+  if (m_superelement && m_superelement->m_arena &&
+      m_superelement->m_arena != m_arena)
+    throw std::logic_error(
+        "Subelements of an arena element must be created in the same arena");
+
+  if (m_arena)
+    m_arena->m_elements.emplace_back(this);
+
+  if (m_superelement) {
     m_superelement->m_subelements.emplace_back(this);
-  else
-    m_bitmap.reset(new bitmap(relative_geometry.size()));
+
+    auto &index = m_root->m_hit_index;
+    index->mark_dirty(this);
+    index->mark_order_dirty();
+  } else {
+    m_bitmap.reset(new bitmap(m_relative_geometry.size()));
+    m_hit_index.reset(new hit_index(this));
+    m_hit_index->mark_dirty(this);
+    m_layer_cache.reset(new layer_cache());
+  }
+
+  m_root->m_draw_order_dirty = true;
+  invalidate();
+
+  if (m_superelement) {
+    m_superelement->request_layout(); // to place the new subelement
+    m_superelement->invalidate_layout();
+  }
 }
 
-element::~element() {
-  for (auto e : m_subelements)
-    delete e;
+void element::detach() {
+  invalidate();
+  std::erase(m_superelement->m_subelements, this);
+  m_root->m_hit_index->remove(this);
+  m_root->m_draw_order_dirty = true;
+  m_superelement->request_layout();
+  m_superelement->invalidate_layout();
+}
+
+void element::release_from_arena() {
+  if (m_root->m_arena == m_arena)
+    return; // the whole tree goes away
+
+  // The root stays, so it has to forget about the element.
+  m_root->m_hit_index->remove(this);
+  if (m_cached)
+    m_root->m_layer_cache->drop(this);
+
+  if (m_superelement->m_arena != m_arena)
+    detach(); // top of a subtree within the arena
+}
+
+void element::mark_moved() {
+  m_absolute_geometry_dirty = true;
+  m_root->m_hit_index->mark_dirty(this);
+
+  for (auto sub : m_subelements)
+    sub->mark_moved();
 }
 
 geometry::rect element::geometry() {
@@ -30,20 +107,118 @@ geometry::rect element::geometry() {
   return result;
 }
 
+void element::set_geometry(const rect &relative_geometry) {
+  if (relative_geometry == m_relative_geometry)
+    return;
+
+  if (relative_geometry.size() != m_relative_geometry.size())
+    request_layout(); // subelements have to fit the new size
+
+  invalidate(); // whatever is left behind at the old place
+  m_relative_geometry = relative_geometry;
+  mark_moved();
+  invalidate();
+}
+
+void element::relocate(const rect &relative_geometry) {
+  if (relative_geometry == m_relative_geometry)
+    return;
+
+  if (relative_geometry.size() != m_relative_geometry.size())
+    request_layout();
+
+  m_relative_geometry = relative_geometry;
+  mark_moved();
+}
+
+void element::set_preferred_size(const size &preferred) {
+  if (preferred == m_preferred_size)
+    return;
+
+  m_preferred_size = preferred;
+  invalidate_layout();
+}
+
+geometry::size element::preferred_size() const { return m_preferred_size; }
+
+void element::set_stretch(int stretch) {
+  if (stretch == m_stretch)
+    return;
+
+  m_stretch = stretch;
+  invalidate_layout();
+}
+
+int element::stretch() const { return m_stretch; }
+
+geometry::size element::measure(const size &) {
+  return m_preferred_size;
+}
+
+void element::arrange() {}
+
+const std::vector<element *> &element::subelements() const {
+  return m_subelements;
+}
+
+geometry::size element::measured_size(const size &available) {
+  if (!m_measure_valid || available != m_measured_available) {
+    m_measured = measure(available);
+    m_measured_available = available;
+    m_measure_valid = true;
+  }
+
+  return m_measured;
+}
+
+void element::request_layout() {
+  m_layout_dirty = true;
+
+  for (auto e = m_superelement; e && !e->m_subtree_layout_dirty;
+       e = e->m_superelement)
+    e->m_subtree_layout_dirty = true;
+}
+
+void element::invalidate_layout() {
+  // Measurements of the superelements depend on this one, and they have to
+  // place it again.
+  for (auto e = this; e; e = e->m_superelement) {
+    e->m_measure_valid = false;
+    if (e->m_superelement)
+      e->m_superelement->request_layout();
+  }
+}
+
+void element::update_layout() {
+  if (m_layout_dirty) {
+    m_layout_dirty = false;
+    arrange();
+  }
+
+  // Arranging marks the subelements which have been resized.
+  if (!m_subtree_layout_dirty)
+    return;
+
+  for (auto sub : m_subelements)
+    sub->update_layout();
+
+  m_subtree_layout_dirty = false;
+}
+
 std::pair<element *, geometry::rect> element::geometry_relative_to_root() {
-  auto super = this;
-  auto geometry = m_relative_geometry;
-
-  while (super) {
-    if (super->m_superelement) {
-      super = super->m_superelement;
-      auto translate_point = super->m_relative_geometry.pos();
-      geometry.move(translate_point.x(), translate_point.y());
-    } else
-      break;
+  if (m_absolute_geometry_dirty) {
+    m_absolute_geometry = m_relative_geometry;
+
+    if (m_superelement) {
+      auto translate_point =
+          m_superelement->geometry_relative_to_root().second.pos();
+      m_absolute_geometry.move(translate_point.x(), translate_point.y());
+    }
+
+    m_absolute_geometry_dirty = false;
   }
 
-  return {super, geometry};
+  return {m_root, m_absolute_geometry};
 }
 
 std::pair<element *, geometry::rect> element::geometry_relative_to_parent() {
@@ -51,71 +226,345 @@ std::pair<element *, geometry::rect> element::geometry_relative_to_parent() {
 }
 
 void element::render_all() {
-  draw();
+  m_root->update_layout();
+  m_root->apply_scrolls(); // the rest of the tree is drawn over them
 
-  auto current = m_subelements.rbegin();
-  auto end = m_subelements.rend();
+  if (m_bitmap)
+    m_damage.clear(); // everything gets redrawn anyway
 
-  while (current != end) {
-    (*current)->render_all();
-    ++current;
+  m_root->update_draw_order();
+
+  painter p(*m_root->m_bitmap);
+  if (m_superelement)
+    p.translate(m_superelement->geometry_relative_to_root().second.pos());
+
+  m_root->render_range(p, m_draw_index, m_subtree_end, nullptr);
+}
+
+void element::update_draw_order() {
+  if (!m_draw_order_dirty)
+    return;
+
+  // An element is drawn first, then its subelements in reverse order of
+  // creation, so that the first one ends up on top.
+  m_draw_order.clear();
+  auto visit = [this](auto &self, element *e) -> void {
+    e->m_draw_index = m_draw_order.size();
+    m_draw_order.emplace_back(e);
+
+    for (auto sub = e->m_subelements.rbegin(); sub != e->m_subelements.rend();
+         ++sub)
+      self(self, *sub);
+
+    e->m_subtree_end = m_draw_order.size();
+  };
+  visit(visit, this);
+
+  m_draw_order_dirty = false;
+}
+
+void element::render_range(painter &p, size_t begin, size_t end,
+                           const rect *area) {
+  // Ends of the subtrees the painter has been saved for; they're nested, so
+  // the innermost one is always at the back. Layers render their subtree
+  // from within, so only the entries above base belong to this call.
+  auto &open = m_open_subtrees;
+  const auto base = open.size();
+
+  for (size_t i = begin; i < end;) {
+    while (open.size() > base && open.back() <= i) {
+      p.restore();
+      open.pop_back();
+    }
+
+    auto e = m_draw_order[i];
+
+    // Subelements are clipped to their superelement, so nothing outside of
+    // the element needs to be visited.
+    if (area &&
+        e->geometry_relative_to_root().second.overlap(*area).area() == 0) {
+      i = e->m_subtree_end;
+      continue;
+    }
+
+    p.save();
+    p.translate(e->m_relative_geometry.pos());
+    p.clip(e->geometry());
+    open.emplace_back(e->m_subtree_end);
+
+    if (e->m_cached && e->draw_layer(p)) {
+      i = e->m_subtree_end;
+      continue;
+    }
+
+    // An opaque subelement covering the whole area hides the element and
+    // every subelement drawn before it, so drawing starts from the topmost
+    // such one.
+    element *cover = nullptr;
+    if (area)
+      for (auto sub : e->m_subelements) {
+        auto bounds = sub->geometry_relative_to_root().second;
+        if (sub->opaque() && bounds.overlap(*area).area() == area->area()) {
+          cover = sub;
+          break;
+        }
+      }
+
+    if (cover)
+      i = cover->m_draw_index;
+    else {
+      e->m_drawn_state = e->visual_state();
+      e->draw(p);
+      ++i;
+    }
   }
+
+  for (; open.size() > base; open.pop_back())
+    p.restore();
 }
 
-void element::draw() {
-  auto painter = get_painter();
-  auto geometry = element::geometry();
+bool element::draw_layer(painter &p) {
+  auto &cache = *m_root->m_layer_cache;
+  auto layer = cache.find(this);
+
+  // Patterns are anchored to the root's bitmap, so a layer only fits where
+  // it has been drawn, or 8 pixels apart.
+  auto origin = geometry_relative_to_root().second.pos();
+  if (layer && ((origin.x() ^ m_layer_origin.x()) & 7 ||
+                (origin.y() ^ m_layer_origin.y()) & 7))
+    layer = nullptr;
+
+  if (!layer) {
+    if (!cache.fits(m_relative_geometry.size()))
+      return false; // would be rejected anyway, draw it directly instead
+
+    bitmap image(m_relative_geometry.size());
+    painter layer_painter(image);
+    layer_painter.set_pattern_origin({-origin.x(), -origin.y()});
+    m_layer_origin = origin;
+    m_drawn_state = visual_state();
+    draw(layer_painter);
+    m_root->render_range(layer_painter, m_draw_index + 1, m_subtree_end,
+                         nullptr);
+
+    layer = cache.insert(this, std::move(image));
+  }
+
+  p.draw_bitmap(*layer, {});
+  return true;
+}
+
+void element::set_cached(bool cached) {
+  m_cached = cached;
+  if (!m_cached)
+    m_root->m_layer_cache->drop(this);
+}
+
+bool element::cached() const { return m_cached; }
+
+layer_cache &element::get_layer_cache() { return *m_root->m_layer_cache; }
+
+void element::drop_layers() {
+  // Layers of the element and of everything it's drawn into are outdated.
+  for (auto e = this; e; e = e->m_superelement)
+    if (e->m_cached)
+      m_root->m_layer_cache->drop(e);
+}
+
+void element::invalidate() { invalidate(geometry()); }
+
+void element::invalidate(const rect &area) {
+  drop_layers();
+
+  auto damage = area;
+  auto origin = geometry_relative_to_root().second.pos();
+  damage.move(origin.x(), origin.y());
+
+  // Nothing is drawn outside of the superelements.
+  for (auto e = m_superelement; e && damage.area() > 0; e = e->m_superelement)
+    damage = e->geometry_relative_to_root().second.overlap(damage);
+
+  m_root->add_damage(damage);
+}
+
+void element::add_damage(rect damage) {
+  damage = m_bitmap->geometry().overlap(damage);
+  if (damage.area() == 0)
+    return;
+
+  // Merge overlapping areas, so that nothing is drawn twice.
+  auto &areas = m_damage;
+  for (auto other = areas.begin(); other != areas.end();)
+    if (other->overlap(damage).area() > 0) {
+      damage = damage.outline(*other);
+      areas.erase(other);
+      other = areas.begin(); // the grown area may overlap the earlier ones
+    } else
+      ++other;
+
+  areas.emplace_back(damage);
+
+  if (areas.size() > max_damage_areas) {
+    auto merged = areas.front();
+    for (const auto &other : areas)
+      merged = merged.outline(other);
+
+    areas = {merged};
+  }
+}
+
+void element::scroll_area(const rect &area, int dy) {
+  drop_layers();
+
+  // Only the part of the area which is actually visible can be shifted.
+  auto origin = geometry_relative_to_root().second.pos();
+  auto shifted = area;
+  shifted.move(origin.x(), origin.y());
+  for (auto e = this; e; e = e->m_superelement)
+    shifted = e->geometry_relative_to_root().second.overlap(shifted);
+
+  if (dy == 0 || shifted.area() == 0)
+    return;
+
+  auto [width, height] = shifted.size().dimensions();
+  if (std::abs(dy) >= height) {
+    m_root->add_damage(shifted); // nothing is left to shift
+    return;
+  }
+
+  // Damage within the area moves along with the pixels, or whatever ends
+  // up there would never be drawn.
+  auto &damage = m_root->m_damage;
+  std::vector<rect> moved;
+  for (auto d = damage.begin(); d != damage.end();) {
+    auto inside = d->overlap(shifted);
+    if (inside.area() == 0) {
+      ++d;
+      continue;
+    }
+
+    inside.move(0, dy);
+    inside = shifted.overlap(inside);
+    moved.emplace_back(inside.area() > 0 ? d->outline(inside) : *d);
+    d = damage.erase(d);
+  }
+
+  for (const auto &d : moved)
+    m_root->add_damage(d);
+
+  auto uncovered = shifted;
+  uncovered.set_size(width, std::abs(dy));
+  if (dy < 0)
+    uncovered.move(0, height + dy);
+  m_root->add_damage(uncovered);
+
+  // Consecutive scrolls of the same area add up.
+  auto &scrolls = m_root->m_scrolls;
+  if (!scrolls.empty() && scrolls.back().first == shifted) {
+    scrolls.back().second += dy;
+    if (scrolls.back().second == 0)
+      scrolls.pop_back();
+  } else
+    scrolls.emplace_back(shifted, dy);
+}
+
+void element::apply_scrolls() {
+  for (const auto &[area, dy] : m_scrolls)
+    m_bitmap->scroll(area, dy);
+
+  m_scrolls.clear();
+}
+
+geometry::rect element::render_damage() {
+  m_root->update_layout(); // may add damage
+
+  auto &damage = m_root->m_damage;
+  auto &scrolls = m_root->m_scrolls;
+  if (damage.empty() && scrolls.empty())
+    return {};
+
+  // Shifted pixels have changed as well, even if they aren't drawn again.
+  auto redrawn = damage.empty() ? scrolls.front().first : damage.front();
+  for (const auto &[area, dy] : scrolls)
+    redrawn = redrawn.outline(area);
 
-  painter->set_point_style(point_style_t::square, 1, true);
-  painter->draw_filled_rect(geometry);
+  m_root->apply_scrolls();
+  m_root->update_draw_order();
 
-  painter->set_point_style(point_style_t::square, 3, false);
-  painter->draw_rect_outline(geometry);
+  painter p(*m_root->m_bitmap);
+  for (const auto &area : damage) {
+    redrawn = redrawn.outline(area);
+
+    p.save();
+    p.clip(area);
+    m_root->render_range(p, 0, m_root->m_draw_order.size(), &area);
+    p.restore();
+  }
+
+  damage.clear();
+
+  return redrawn;
 }
 
-std::shared_ptr<painter> element::get_painter() {
-  auto [root, geometry] = geometry_relative_to_root();
-  return std::make_shared<painter>(*root->m_bitmap.get(), geometry);
+void element::draw(painter &p) {
+  auto geometry = element::geometry();
+
+  p.set_point_style(point_style_t::square, 1, true);
+  p.draw_filled_rect(geometry);
+
+  p.set_point_style(point_style_t::square, 3, false);
+  p.draw_rect_outline(geometry);
 }
 
 bool element::on_touch_event(const event &ev) { return false; }
 
+uint64_t element::visual_state() const { return 0; }
+
+bool element::opaque() const { return true; }
+
+bool element::react(const event &ev) {
+  if (!on_touch_event(ev))
+    return false;
+
+  // Unchanged elements cost neither a redraw nor a present.
+  if (visual_state() != m_drawn_state)
+    invalidate();
+
+  return true;
+}
+
 element *element::get_superelement() { return m_superelement; }
 
-element *element::get_root_element() {
-  if (!m_superelement)
-    return this;
+element *element::get_root_element() { return m_root; }
 
-  auto super = m_superelement;
-  while (super)
-    if (super->m_superelement)
-      super = super->m_superelement;
-    else
-      break;
+bitmap &element::get_bitmap() { return *m_root->m_bitmap.get(); }
 
-  return super;
+bool element::process_event(const ui_event &ev) {
+  return std::visit([this](const auto &e) { return dispatch(e); }, ev);
 }
 
-bitmap &element::get_bitmap() { return *get_root_element()->m_bitmap.get(); }
+bool element::process_event(const event &ev) { return dispatch(ev); }
+
+bool element::dispatch(const event &ev) {
+  if (m_hit_index) {
+    // Root element: only the elements under the touch are tried.
+    const geometry::point p{ev.x, ev.y};
+    update_layout();
+
+    for (const auto &candidate : m_hit_index->candidates(p))
+      if (candidate.bounds.contains(p) && candidate.target->react(ev))
+        return true;
 
-bool element::process_event(const std::any &ev) {
-  if (ev.type() != typeid(event) || !ev.has_value())
     return false;
+  }
 
   for (auto sub : m_subelements)
-    if (sub->process_event(ev))
+    if (sub->dispatch(ev))
       return true;
 
-  event e = any_cast<event>(ev);
   auto [element, geometry] = geometry_relative_to_root();
 
-  if (geometry.contains({e.x, e.y}))
-    if (on_touch_event(e)) {
-      render_all();
-      return true;
-    }
-
-  return false;
+  return geometry.contains({ev.x, ev.y}) && react(ev);
 }
 
 } // namespace ui
@@ -1,39 +1,232 @@
 #pragma once
 
 #include "bitmap.h"
+#include "layer_cache.h"
 #include "painter.h"
 
 #include <touch.h>
+#include <ui_event.h>
 
-#include <any>
-#include <list>
 #include <memory>
+#include <vector>
 
 namespace ui {
 
+class element_arena;
+class hit_index;
+
 class element {
+  friend class element_arena;
+  friend class hit_index;
+
   using rect = geometry::rect;
+  using size = geometry::size;
 
   std::unique_ptr<bitmap> m_bitmap;
+  std::unique_ptr<hit_index> m_hit_index;     // root element only
+  std::unique_ptr<layer_cache> m_layer_cache; // root element only
 
   rect m_relative_geometry;
-  std::list<element *> m_subelements;
+  std::vector<element *> m_subelements;
   element *m_superelement;
+  element *m_root = nullptr;
+  element_arena *m_arena = nullptr;
+  size_t m_dispatch_rank = 0;
+  bool m_cached = false;
+  geometry::point m_layer_origin; // relative to the root, when last cached
+
+  // element::visual_state as of the last time the element has been drawn
+  uint64_t m_drawn_state = 0;
+
+  // Position in the root's draw order: the element is followed by its
+  // subtree, which ends right before m_subtree_end.
+  size_t m_draw_index = 0;
+  size_t m_subtree_end = 0;
+
+  // Geometry relative to the root element; recalculated on demand after the
+  // element or any of its superelements has been moved.
+  rect m_absolute_geometry;
+  bool m_absolute_geometry_dirty = true;
+
+  // Layout: the preferred size, the last measurement, and whether the
+  // element or any element in its subtree has to be arranged again.
+  size m_preferred_size;
+  int m_stretch = 0;
+  size m_measured_available;
+  size m_measured;
+  bool m_measure_valid = false;
+  bool m_layout_dirty = false;
+  bool m_subtree_layout_dirty = false;
+
+  // Root element only: areas to redraw, relative to the root, areas to
+  // shift by a number of rows before that, the whole tree flattened in the
+  // order of drawing, and the ends of the subtrees render_range has saved
+  // the painter for, kept to reuse the allocation.
+  std::vector<rect> m_damage;
+  std::vector<std::pair<rect, int>> m_scrolls;
+  std::vector<element *> m_draw_order;
+  bool m_draw_order_dirty = true;
+  std::vector<size_t> m_open_subtrees;
+
+  void attach();
+  void detach();
+  void release_from_arena();
+  void mark_moved();
+  void drop_layers();
+  void add_damage(rect area);
+  void apply_scrolls();
+  void update_draw_order();
+  void render_range(painter &p, size_t begin, size_t end, const rect *area);
+  bool draw_layer(painter &p);
+  bool react(const event &ev);
+  bool dispatch(const event &ev);
 
 protected:
-  virtual void draw();
+  /**
+   * Draw the element itself; the painter is translated and clipped to the
+   * element, i.e. coordinates are the same as in element::geometry.
+   */
+  virtual void draw(painter &p);
+
+  /**
+   * React on a touch event. Changes of element::visual_state are drawn
+   * without further ado; anything else has to be invalidated.
+   * @return true if the element has reacted on the event
+   */
   virtual bool on_touch_event(const event &ev);
 
-  std::shared_ptr<painter> get_painter();
+  /**
+   * Get a value which changes whenever the look of the element does, e.g.
+   * a toggled state. After an event, the element is drawn again only if the
+   * value differs from the one it has been drawn with. The look of elements
+   * never changes by default.
+   */
+  virtual uint64_t visual_state() const;
+
+  /**
+   * Does element::draw cover every pixel of the element?
+   */
+  virtual bool opaque() const;
+
+  /**
+   * Get the size the element would like to have; the preferred size by
+   * default. Called through element::measured_size, which caches the result.
+   * @param available space the superelement can offer
+   */
+  virtual size measure(const size &available);
+
+  /**
+   * Position the subelements within the element, e.g. with set_geometry.
+   * Called by element::update_layout once the element or its preferred size
+   * has changed; does nothing by default.
+   */
+  virtual void arrange();
+
+  /**
+   * Arrange the element on the next element::update_layout, e.g. once
+   * settings of a layout which affect the placement have changed.
+   */
+  void request_layout();
+
+  /**
+   * Shift the pixels of an area of the element vertically on the next render
+   * instead of drawing them again; only the strip which gets uncovered is
+   * invalidated. Nothing else may be drawn over the area, since it would be
+   * shifted along.
+   * @param area area relative to this element, as in element::geometry
+   * @param dy rows to shift by, positive to shift down
+   */
+  void scroll_area(const rect &area, int dy);
+
+  /**
+   * Get the subelements in order of creation.
+   */
+  const std::vector<element *> &subelements() const;
 
 public:
   element(const rect &relative_geometry, element *superelement = nullptr);
   element(rect &&relative_geometry, element *superelement = nullptr);
-  ~element();
+  virtual ~element();
 
   void render_all();
 
+  /**
+   * Render the element with its subelements into an offscreen layer once,
+   * and copy the layer from then on, until anything within it gets
+   * invalidated. Meant for subtrees which rarely change.
+   */
+  void set_cached(bool cached);
+  bool cached() const;
+
+  /**
+   * Get the layer cache shared by the whole element tree.
+   */
+  layer_cache &get_layer_cache();
+
+  /**
+   * Mark the whole element as in need of a redraw.
+   */
+  void invalidate();
+
+  /**
+   * Mark an area as in need of a redraw.
+   * @param area area relative to this element, as in element::geometry
+   */
+  void invalidate(const rect &area);
+
+  /**
+   * Redraw every element intersecting the invalidated areas, limited to those
+   * areas.
+   * @return area which has been redrawn, relative to the root element; zero
+   * sized if nothing was invalidated
+   */
+  rect render_damage();
+
   rect geometry();
+
+  /**
+   * Move and/or resize the element.
+   * @param relative_geometry new geometry relative to the superelement
+   */
+  void set_geometry(const rect &relative_geometry);
+
+  /**
+   * Move and/or resize the element without invalidating anything, for when
+   * its pixels have been moved already, see element::scroll_area.
+   */
+  void relocate(const rect &relative_geometry);
+
+  /**
+   * Set the size layouts should give the element; it's the size the element
+   * has been created with by default.
+   */
+  void set_preferred_size(const size &preferred);
+  size preferred_size() const;
+
+  /**
+   * Set the share of the free space layouts should give the element, in
+   * addition to its measured size.
+   */
+  void set_stretch(int stretch);
+  int stretch() const;
+
+  /**
+   * Get the measured size, measuring the element only if anything affecting
+   * it has changed since the last time.
+   */
+  size measured_size(const size &available);
+
+  /**
+   * The size of the element's content has changed: measure it again, and
+   * arrange its superelements again on the next element::update_layout.
+   */
+  void invalidate_layout();
+
+  /**
+   * Arrange every element in the subtree which needs it.
+   */
+  void update_layout();
+
   std::pair<element *, rect> geometry_relative_to_root();
   std::pair<element *, rect> geometry_relative_to_parent();
 
@@ -42,7 +235,12 @@ public:
 
   bitmap &get_bitmap();
 
-  bool process_event(const std::any &ev);
+  /**
+   * Dispatch an event through this element and its subelements.
+   * @return true if any element has reacted on the event
+   */
+  bool process_event(const ui_event &ev);
+  bool process_event(const event &ev);
 };
 
 } // namespace ui
@@ -0,0 +1,52 @@
+#include "element_arena.h"
+
+#include "element.h"
+
+#include <algorithm>
+
+namespace ui {
+
+thread_local element_arena *element_arena::s_constructing = nullptr;
+
+element_arena::element_arena(size_t block_size) : m_block_size(block_size) {}
+
+element_arena::~element_arena() { clear(); }
+
+void *element_arena::allocate(size_t size, size_t alignment) {
+  for (auto &b : m_blocks) {
+    auto offset = (b.used + alignment - 1) / alignment * alignment;
+    if (offset + size <= b.size) {
+      b.used = offset + size;
+      return b.data.get() + offset;
+    }
+  }
+
+  // operator new[] storage is aligned for any fundamental type.
+  auto block_size = std::max(m_block_size, size);
+  m_blocks.push_back({std::make_unique<std::byte[]>(block_size), block_size,
+                      size});
+  return m_blocks.back().data.get();
+}
+
+void element_arena::clear() {
+  m_tearing_down = true;
+
+  for (auto e : m_elements)
+    e->release_from_arena();
+
+  // Subelements first, so that the tree stays consistent till the end.
+  for (auto e = m_elements.rbegin(); e != m_elements.rend(); ++e)
+    (*e)->~element();
+
+  m_elements.clear();
+  m_tearing_down = false;
+
+  if (m_blocks.size() > 1)
+    m_blocks.resize(1);
+  for (auto &b : m_blocks)
+    b.used = 0;
+}
+
+size_t element_arena::size() const { return m_elements.size(); }
+
+} // namespace ui
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ui {
+
+class element;
+
+/**
+ * Owns the storage of a set of elements, e.g. of a single screen.
+ *
+ * Elements are placed next to each other in large blocks instead of separate
+ * heap allocations, and are all destroyed with a single element_arena::clear
+ * call: the subtrees get detached from the elements outside of the arena
+ * first, and the rest of the bookkeeping is skipped.
+ *
+ * Subelements of an element created in an arena have to be created in the
+ * same arena. Elements in an arena must not be deleted on their own, and the
+ * arena has to be cleared before any of the superelements outside of it are
+ * destroyed.
+ */
+class element_arena {
+  friend class element;
+
+  struct block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+    size_t used;
+  };
+
+  size_t m_block_size;
+  std::vector<block> m_blocks;
+  std::vector<element *> m_elements; // in order of creation
+  bool m_tearing_down = false;
+
+  static thread_local element_arena *s_constructing;
+
+  void *allocate(size_t size, size_t alignment);
+
+public:
+  explicit element_arena(size_t block_size = 4096);
+  ~element_arena();
+
+  element_arena(const element_arena &) = delete;
+  element_arena &operator=(const element_arena &) = delete;
+
+  /**
+   * Create an element (or a widget derived from it) in the arena.
+   * @param args constructor arguments
+   * @return created element, owned by the arena
+   */
+  template <typename T, typename... Args> T *create(Args &&...args) {
+    auto storage = allocate(sizeof(T), alignof(T));
+
+    s_constructing = this;
+    try {
+      auto result = new (storage) T(std::forward<Args>(args)...);
+      s_constructing = nullptr;
+      return result;
+    } catch (...) {
+      s_constructing = nullptr;
+      throw;
+    }
+  }
+
+  /**
+   * Destroy all elements of the arena at once. The storage is kept for reuse.
+   */
+  void clear();
+
+  /**
+   * Get the number of elements in the arena.
+   */
+  size_t size() const;
+};
+
+} // namespace ui
@@ -0,0 +1,478 @@
+#include "font.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+static const bytes::byte psf1_magic[] = {0x36, 0x04};
+static const bytes::byte psf2_magic[] = {0x72, 0xb5, 0x4a, 0x86};
+
+static const uint8_t psf1_mode_512 = 0x01;
+static const uint8_t psf1_mode_has_table = 0x06;
+static const uint32_t psf2_has_table = 0x01;
+
+static const char32_t replacement_character = 0xfffd;
+
+[[noreturn]] static void throw_malformed(const std::filesystem::path &p,
+                                         const std::string &what) {
+  std::stringstream error;
+  error << "Malformed font file " << p << ": " << what;
+  throw std::runtime_error(error.str());
+}
+
+static uint32_t le32(const bytes::vect &data, size_t offset) {
+  return data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 |
+         uint32_t(data[offset + 3]) << 24;
+}
+
+// Decode a single code point, advancing the position past it.
+static char32_t decode_utf8(const std::string &text, size_t &pos) {
+  auto lead = static_cast<unsigned char>(text[pos++]);
+  if (lead < 0x80)
+    return lead;
+
+  int length = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : lead >= 0xc0 ? 1 : -1;
+  if (length < 0)
+    return replacement_character;
+
+  char32_t result = lead & (0x3f >> length);
+  for (int i = 0; i < length; ++i) {
+    if (pos >= text.size() || (text[pos] & 0xc0) != 0x80)
+      return replacement_character;
+    result = result << 6 | (text[pos++] & 0x3f);
+  }
+
+  return result;
+}
+
+// Glyph row with the leftmost pixel in the most significant bit.
+static uint32_t row_word(const bytes::byte *row, int bytes) {
+  uint32_t result = 0;
+  for (int i = 0; i < 4; ++i)
+    result = result << 8 | (i < bytes ? row[i] : 0);
+  return result;
+}
+
+namespace ui {
+
+size_t font::layout_key_hash::operator()(const layout_key &key) const {
+  return std::hash<std::string>()(key.first) ^ std::hash<int>()(key.second);
+}
+
+void font::add_glyph(const glyph &metrics, const std::vector<uint32_t> &rows) {
+  if (metrics.width > max_glyph_width)
+    throw std::runtime_error("Glyphs wider than 32 pixels are not supported");
+
+  auto result = metrics;
+  result.first_row = m_atlas.size();
+  result.height = rows.size();
+
+  // Drop whatever is past the glyph width, it would smear the neighbours.
+  uint32_t mask = result.width ? ~0u << (max_glyph_width - result.width) : 0;
+  for (auto row : rows)
+    m_atlas.emplace_back(row & mask);
+
+  m_glyphs.emplace_back(result);
+}
+
+void font::map(char32_t code_point, uint32_t glyph) {
+  m_map.emplace(code_point, glyph);
+}
+
+void font::finish() {
+  auto question_mark = m_map.find('?');
+  if (question_mark != m_map.end())
+    m_fallback = question_mark->second;
+
+  for (char32_t c = 0; c < 128; ++c) {
+    auto found = m_map.find(c);
+    m_ascii[c] = found != m_map.end() ? found->second : m_fallback;
+  }
+}
+
+font font::parse_psf1(const bytes::vect &data, const path &p) {
+  if (data.size() < 4)
+    throw_malformed(p, "truncated header");
+
+  auto mode = data[2];
+  int height = data[3];
+  size_t count = mode & psf1_mode_512 ? 512 : 256;
+  size_t offset = 4;
+
+  if (data.size() < offset + count * height)
+    throw_malformed(p, "truncated glyphs");
+
+  font result;
+  result.m_ascent = height;
+
+  std::vector<uint32_t> rows(height);
+  for (size_t g = 0; g < count; ++g, offset += height) {
+    for (int row = 0; row < height; ++row)
+      rows[row] = uint32_t(data[offset + row]) << 24;
+
+    result.add_glyph({8, height, 0, 0, 8}, rows);
+  }
+
+  if (mode & psf1_mode_has_table) {
+    // Per glyph: 16 bit code points, then sequences after 0xfffe, up to 0xffff
+    for (size_t g = 0; g < count && offset + 1 < data.size(); ++g) {
+      bool sequences = false;
+
+      while (offset + 1 < data.size()) {
+        uint16_t value = data[offset] | data[offset + 1] << 8;
+        offset += 2;
+
+        if (value == 0xffff)
+          break;
+        if (value == 0xfffe)
+          sequences = true;
+        else if (!sequences)
+          result.map(value, g);
+      }
+    }
+  } else
+    for (size_t g = 0; g < count; ++g)
+      result.map(g, g);
+
+  result.finish();
+  return result;
+}
+
+font font::parse_psf2(const bytes::vect &data, const path &p) {
+  if (data.size() < 32)
+    throw_malformed(p, "truncated header");
+
+  size_t header_size = le32(data, 8);
+  auto flags = le32(data, 12);
+  size_t count = le32(data, 16);
+  size_t glyph_size = le32(data, 20);
+  int height = le32(data, 24);
+  int width = le32(data, 28);
+  int row_bytes = (width + 7) / 8;
+
+  if (glyph_size < size_t(row_bytes) * height)
+    throw_malformed(p, "glyph size doesn't match the dimensions");
+  if (data.size() < header_size + count * glyph_size)
+    throw_malformed(p, "truncated glyphs");
+
+  font result;
+  result.m_ascent = height;
+
+  std::vector<uint32_t> rows(height);
+  size_t offset = header_size;
+  for (size_t g = 0; g < count; ++g, offset += glyph_size) {
+    for (int row = 0; row < height; ++row)
+      rows[row] = row_word(&data[offset + row * row_bytes], row_bytes);
+
+    result.add_glyph({width, height, 0, 0, width}, rows);
+  }
+
+  if (flags & psf2_has_table) {
+    // Per glyph: UTF-8 characters, then sequences after 0xfe, up to 0xff
+    for (size_t g = 0; g < count && offset < data.size(); ++g) {
+      std::string characters;
+      while (offset < data.size() && data[offset] != 0xff &&
+             data[offset] != 0xfe)
+        characters += static_cast<char>(data[offset++]);
+
+      while (offset < data.size() && data[offset++] != 0xff)
+        ; // skip sequences
+
+      for (size_t pos = 0; pos < characters.size();)
+        result.map(decode_utf8(characters, pos), g);
+    }
+  } else
+    for (size_t g = 0; g < count; ++g)
+      result.map(g, g);
+
+  result.finish();
+  return result;
+}
+
+font font::parse_bdf(std::istream &input, const path &p) {
+  font result;
+
+  int box_height = 0;
+  int box_y = 0;
+  bool has_ascent = false;
+  bool has_descent = false;
+
+  std::string line;
+  std::string keyword;
+
+  // Glyph positions are relative to the baseline in BDF, so the glyphs are
+  // only added once the ascent is known, i.e. at the end.
+  struct pending_glyph {
+    int encoding = -1;
+    int advance = 0;
+    int width = 0;
+    int height = 0;
+    int x_offset = 0;
+    int y_offset = 0;
+    std::vector<uint32_t> rows;
+  };
+  std::vector<pending_glyph> pending;
+  pending_glyph current;
+
+  while (std::getline(input, line)) {
+    std::istringstream fields(line);
+    if (!(fields >> keyword))
+      continue; // empty line
+
+    if (keyword == "FONTBOUNDINGBOX") {
+      int box_width, box_x;
+      fields >> box_width >> box_height >> box_x >> box_y;
+    } else if (keyword == "FONT_ASCENT") {
+      fields >> result.m_ascent;
+      has_ascent = true;
+    } else if (keyword == "FONT_DESCENT") {
+      fields >> result.m_descent;
+      has_descent = true;
+    } else if (keyword == "STARTCHAR")
+      current = {};
+    else if (keyword == "ENCODING")
+      fields >> current.encoding;
+    else if (keyword == "DWIDTH")
+      fields >> current.advance;
+    else if (keyword == "BBX")
+      fields >> current.width >> current.height >> current.x_offset >>
+          current.y_offset;
+    else if (keyword == "BITMAP") {
+      for (int row = 0; row < current.height; ++row) {
+        if (!std::getline(input, line))
+          throw_malformed(p, "truncated bitmap");
+
+        bytes::byte row_bytes[4] = {};
+        for (size_t i = 0; i + 1 < line.size() && i / 2 < 4; i += 2)
+          row_bytes[i / 2] = std::stoi(line.substr(i, 2), nullptr, 16);
+
+        current.rows.emplace_back(row_word(row_bytes, 4));
+      }
+    } else if (keyword == "ENDCHAR")
+      pending.emplace_back(std::move(current));
+
+    if (fields.fail())
+      throw_malformed(p, "bad line \"" + line + "\"");
+  }
+
+  if (pending.empty())
+    throw_malformed(p, "no glyphs");
+
+  if (!has_ascent)
+    result.m_ascent = box_height + box_y;
+  if (!has_descent)
+    result.m_descent = -box_y;
+
+  for (const auto &g : pending) {
+    if (g.encoding >= 0)
+      result.map(g.encoding, result.m_glyphs.size());
+    result.add_glyph({g.width, g.height, g.x_offset,
+                      result.m_ascent - g.y_offset - g.height, g.advance},
+                     g.rows);
+  }
+
+  result.finish();
+  return result;
+}
+
+font font::load(const path &p) {
+  std::ifstream input(p, std::ios::binary);
+  if (!input.good()) {
+    std::stringstream error;
+    error << "Failed to open file: " << p;
+    throw std::runtime_error(error.str());
+  }
+
+  const bytes::vect data{std::istreambuf_iterator<char>(input),
+                         std::istreambuf_iterator<char>()};
+
+  if (data.size() >= 2 && std::equal(std::begin(psf1_magic),
+                                     std::end(psf1_magic), data.begin()))
+    return parse_psf1(data, p);
+
+  if (data.size() >= 4 && std::equal(std::begin(psf2_magic),
+                                     std::end(psf2_magic), data.begin()))
+    return parse_psf2(data, p);
+
+  const std::string bdf_magic = "STARTFONT";
+  if (data.size() >= bdf_magic.size() &&
+      std::equal(bdf_magic.begin(), bdf_magic.end(), data.begin())) {
+    std::istringstream text(std::string(data.begin(), data.end()));
+    return parse_bdf(text, p);
+  }
+
+  std::stringstream error;
+  error << "Unknown font format: " << p;
+  throw std::runtime_error(error.str());
+}
+
+uint32_t font::glyph_index(char32_t code_point) const {
+  if (code_point < 128)
+    return m_ascii[code_point];
+
+  auto found = m_map.find(code_point);
+  return found != m_map.end() ? found->second : m_fallback;
+}
+
+const font::glyph &font::glyph_metrics(uint32_t index) const {
+  return m_glyphs[index];
+}
+
+size_t font::glyph_count() const { return m_glyphs.size(); }
+
+int font::ascent() const { return m_ascent; }
+
+int font::descent() const { return m_descent; }
+
+int font::line_height() const { return m_ascent + m_descent; }
+
+std::shared_ptr<text_layout> font::shape(const std::string &text,
+                                         int max_width) const {
+  auto result = std::make_shared<text_layout>();
+  auto &glyphs = result->glyphs;
+  auto &line_widths = result->line_widths;
+
+  int x = 0;
+  int y = 0;
+  size_t line_start = 0;
+
+  // Glyph the line can be broken before, i.e. the one after the last space,
+  // and the width of the line without that space.
+  size_t break_at = 0;
+  int width_at_break = 0;
+
+  for (size_t pos = 0; pos < text.size();) {
+    auto c = decode_utf8(text, pos);
+
+    if (c == '\n') {
+      line_widths.emplace_back(x);
+      x = 0;
+      y += line_height();
+      line_start = glyphs.size();
+      break_at = 0;
+      continue;
+    }
+
+    auto index = glyph_index(c);
+    auto advance = m_glyphs[index].advance;
+
+    if (max_width > 0 && x + advance > max_width && break_at > line_start &&
+        break_at <= glyphs.size()) {
+      // Move the last word to a new line.
+      int shift = break_at < glyphs.size() ? glyphs[break_at].x : x;
+      for (auto g = glyphs.begin() + break_at; g != glyphs.end(); ++g) {
+        g->x -= shift;
+        g->y += line_height();
+      }
+
+      line_widths.emplace_back(width_at_break);
+      x -= shift;
+      y += line_height();
+      line_start = break_at;
+      break_at = 0;
+    }
+
+    if (c == ' ') {
+      break_at = glyphs.size() + 1;
+      width_at_break = x;
+    }
+
+    glyphs.push_back({index, x, y});
+    x += advance;
+  }
+
+  line_widths.emplace_back(x);
+  result->size = {*std::max_element(line_widths.begin(), line_widths.end()),
+                  int(line_widths.size()) * line_height()};
+
+  return result;
+}
+
+std::shared_ptr<const text_layout> font::layout(const std::string &text,
+                                                int max_width) const {
+  layout_key key{text, max_width};
+
+  auto found = m_layout_index.find(key);
+  if (found != m_layout_index.end()) {
+    m_layouts.splice(m_layouts.begin(), m_layouts, found->second);
+    return found->second->second;
+  }
+
+  auto result = shape(text, max_width);
+  m_layouts.emplace_front(key, result);
+  m_layout_index[std::move(key)] = m_layouts.begin();
+
+  while (m_layouts.size() > m_layout_cache_size) {
+    m_layout_index.erase(m_layouts.back().first);
+    m_layouts.pop_back();
+  }
+
+  return result;
+}
+
+void font::set_layout_cache_size(size_t layouts) {
+  m_layout_cache_size = layouts;
+
+  while (m_layouts.size() > m_layout_cache_size) {
+    m_layout_index.erase(m_layouts.back().first);
+    m_layouts.pop_back();
+  }
+}
+
+void font::draw(bitmap &target, const geometry::rect &clip,
+                const geometry::point &to, const text_layout &text,
+                bool white) const {
+  auto area = target.geometry().overlap(clip);
+  auto [clip_x1, clip_y1] = area.top_left().coords();
+  auto [clip_x2, clip_y2] = area.bottom_right().coords();
+
+  auto data = target.raw_data().data();
+  const int row_bytes = target.bytes_per_row();
+
+  for (const auto &placed : text.glyphs) {
+    const auto &g = m_glyphs[placed.glyph];
+    int x = to.x() + placed.x + g.x_offset;
+    int y = to.y() + placed.y + g.y_offset;
+
+    if (x >= clip_x2 || x + g.width <= clip_x1 || y >= clip_y2 ||
+        y + g.height <= clip_y1)
+      continue;
+
+    // Columns of the glyph within the clip area, as a mask of the row word.
+    int first_column = std::max(0, clip_x1 - x);
+    int last_column = std::min(g.width, clip_x2 - x); // exclusive
+    uint32_t mask = ~0u >> first_column;
+    if (last_column < max_glyph_width)
+      mask &= ~(~0u >> last_column);
+
+    // The row word spans up to five bytes once shifted to its position.
+    int first_byte = x >> 3;
+    int shift = x & 7;
+
+    int first_row = std::max(0, clip_y1 - y);
+    int last_row = std::min(g.height, clip_y2 - y);
+
+    for (int row = first_row; row < last_row; ++row) {
+      uint64_t bits = uint64_t(m_atlas[g.first_row + row] & mask)
+                      << (32 - shift);
+      if (!bits)
+        continue;
+
+      auto dst = data + (y + row) * row_bytes;
+      for (int i = 0; i < 5; ++i) {
+        uint8_t ink = bits >> (56 - 8 * i);
+        if (!ink)
+          continue;
+
+        // Masked columns are within the clip area, so is the byte.
+        if (white)
+          dst[first_byte + i] |= ink;
+        else
+          dst[first_byte + i] &= ~ink;
+      }
+    }
+  }
+}
+
+} // namespace ui
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "bitmap.h"
+
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ui {
+
+/**
+ * Glyphs placed by font::layout, relative to the top left corner of the text.
+ */
+struct text_layout {
+  struct placed_glyph {
+    uint32_t glyph; // index in the font
+    int x;
+    int y;
+  };
+
+  std::vector<placed_glyph> glyphs;
+  std::vector<int> line_widths;
+  geometry::size size;
+};
+
+/**
+ * Monochrome bitmap font, loaded from a PSF (version 1 or 2) or a BDF file.
+ *
+ * All glyphs are packed into a single atlas of 32 bit words, one per glyph
+ * row, with the leftmost pixel in the most significant bit; a set bit is
+ * ink. That way a glyph row gets drawn with a couple of shifts and masked
+ * byte writes, whatever its position.
+ */
+class font {
+public:
+  using path = std::filesystem::path;
+
+  /**
+   * Glyphs can't be wider than that.
+   */
+  static constexpr int max_glyph_width = 32;
+
+  struct glyph {
+    int width = 0;
+    int height = 0;
+    int x_offset = 0; // from the pen position
+    int y_offset = 0; // from the top of the line
+    int advance = 0;
+    size_t first_row = 0; // in the atlas
+  };
+
+private:
+  std::vector<uint32_t> m_atlas;
+  std::vector<glyph> m_glyphs;
+  std::unordered_map<char32_t, uint32_t> m_map;
+  uint32_t m_ascii[128] = {};
+  uint32_t m_fallback = 0;
+
+  int m_ascent = 0;
+  int m_descent = 0;
+
+  // Layouts of recently used strings, most recent first
+  using layout_key = std::pair<std::string, int>;
+  struct layout_key_hash {
+    size_t operator()(const layout_key &key) const;
+  };
+
+  mutable std::list<std::pair<layout_key, std::shared_ptr<text_layout>>>
+      m_layouts;
+  mutable std::unordered_map<layout_key, decltype(m_layouts)::iterator,
+                             layout_key_hash>
+      m_layout_index;
+  size_t m_layout_cache_size = 64;
+
+  font() = default;
+
+  void add_glyph(const glyph &metrics, const std::vector<uint32_t> &rows);
+  void map(char32_t code_point, uint32_t glyph);
+  void finish();
+
+  static font parse_psf1(const bytes::vect &data, const path &p);
+  static font parse_psf2(const bytes::vect &data, const path &p);
+  static font parse_bdf(std::istream &input, const path &p);
+
+  std::shared_ptr<text_layout> shape(const std::string &text,
+                                     int max_width) const;
+
+public:
+  font(font &&) = default;
+  font &operator=(font &&) = default;
+
+  /**
+   * Load a font, detecting the format by the contents of the file.
+   */
+  static font load(const path &p);
+
+  /**
+   * Get the glyph of a character, or the fallback glyph (the one for '?',
+   * if there's any) for characters the font doesn't have.
+   */
+  uint32_t glyph_index(char32_t code_point) const;
+  const glyph &glyph_metrics(uint32_t index) const;
+  size_t glyph_count() const;
+
+  int ascent() const;
+  int descent() const;
+  int line_height() const;
+
+  /**
+   * Place the glyphs of a UTF-8 string. Results are cached, so repeated
+   * layouts of the same strings cost a hash lookup; the cache makes this
+   * the only method which isn't safe to call from several threads at once.
+   * @param max_width break lines between words to fit into that width; 0 to
+   * only break on '\n'
+   */
+  std::shared_ptr<const text_layout> layout(const std::string &text,
+                                            int max_width = 0) const;
+
+  /**
+   * Set how many string layouts are kept.
+   */
+  void set_layout_cache_size(size_t layouts);
+
+  /**
+   * Draw laid out text.
+   * @param target bitmap to draw into
+   * @param clip area of the target to limit the drawing to
+   * @param to position of the top left corner of the text in the target
+   * @param white draw white text instead of black
+   */
+  void draw(bitmap &target, const geometry::rect &clip,
+            const geometry::point &to, const text_layout &text,
+            bool white = false) const;
+};
+
+} // namespace ui
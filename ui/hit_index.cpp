@@ -0,0 +1,117 @@
+#include "hit_index.h"
+
+#include "element.h"
+
+#include <algorithm>
+
+#include <math_util.h>
+
+namespace ui {
+
+bool hit_index::dispatched_earlier(const entry &a, const entry &b) {
+  return a.target->m_dispatch_rank < b.target->m_dispatch_rank;
+}
+
+hit_index::hit_index(element *root, int cell_size)
+    : m_root(root), m_area(root->geometry()), m_cell_size(cell_size) {
+  m_columns = std::max(1, div_ceil(m_area.size().width() + 1, cell_size));
+  m_rows = std::max(1, div_ceil(m_area.size().height() + 1, cell_size));
+  m_cells.resize(m_columns * m_rows);
+}
+
+std::pair<int, int> hit_index::cell_of(const point &p) const {
+  auto column = (p.x() - m_area.pos().x()) / m_cell_size;
+  auto row = (p.y() - m_area.pos().y()) / m_cell_size;
+
+  return {std::clamp(column, 0, m_columns - 1), std::clamp(row, 0, m_rows - 1)};
+}
+
+std::vector<hit_index::entry> &hit_index::cell(int column, int row) {
+  return m_cells[row * m_columns + column];
+}
+
+void hit_index::erase(element *e, const rect &bounds) {
+  auto [min_column, min_row] = cell_of(bounds.top_left());
+  auto [max_column, max_row] = cell_of(bounds.bottom_right());
+
+  for (int row = min_row; row <= max_row; ++row)
+    for (int column = min_column; column <= max_column; ++column)
+      std::erase_if(cell(column, row),
+                    [e](const entry &item) { return item.target == e; });
+}
+
+void hit_index::insert(element *e, const rect &bounds) {
+  auto [min_column, min_row] = cell_of(bounds.top_left());
+  auto [max_column, max_row] = cell_of(bounds.bottom_right());
+  const entry item{e, bounds};
+
+  for (int row = min_row; row <= max_row; ++row)
+    for (int column = min_column; column <= max_column; ++column) {
+      auto &c = cell(column, row);
+
+      if (m_order_dirty)
+        c.emplace_back(item); // will be sorted anyway
+      else
+        c.insert(std::upper_bound(c.begin(), c.end(), item, dispatched_earlier),
+                 item);
+    }
+}
+
+void hit_index::update_order() {
+  // Dispatch order: subelements first, in order of creation; then the
+  // element itself. That's a post-order traversal of the tree.
+  size_t rank = 0;
+  auto assign = [&rank](auto &self, element *e) -> void {
+    for (auto sub : e->m_subelements)
+      self(self, sub);
+    e->m_dispatch_rank = rank++;
+  };
+  assign(assign, m_root);
+
+  for (auto &c : m_cells)
+    std::sort(c.begin(), c.end(), dispatched_earlier);
+
+  m_order_dirty = false;
+}
+
+void hit_index::flush() {
+  for (auto e : m_dirty) {
+    auto indexed = m_indexed.find(e);
+    if (indexed != m_indexed.end())
+      erase(e, indexed->second);
+
+    auto bounds = e->geometry_relative_to_root().second;
+    insert(e, bounds);
+    m_indexed[e] = bounds;
+  }
+
+  m_dirty.clear();
+
+  if (m_order_dirty)
+    update_order();
+}
+
+void hit_index::mark_dirty(element *e) { m_dirty.insert(e); }
+
+void hit_index::mark_order_dirty() { m_order_dirty = true; }
+
+void hit_index::remove(element *e) {
+  m_dirty.erase(e);
+
+  auto indexed = m_indexed.find(e);
+  if (indexed == m_indexed.end())
+    return;
+
+  erase(e, indexed->second);
+  m_indexed.erase(indexed);
+}
+
+const std::vector<hit_index::entry> &hit_index::candidates(const point &p) {
+  if (!m_dirty.empty() || m_order_dirty)
+    flush();
+
+  auto [column, row] = cell_of(p);
+  return cell(column, row);
+}
+
+} // namespace ui
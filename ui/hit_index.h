@@ -0,0 +1,82 @@
+#pragma once
+
+#include <rect.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ui {
+
+class element;
+
+/**
+ * Uniform grid over absolute element rectangles, used to route a touch to
+ * the elements under it with a single lookup instead of walking the whole
+ * element tree.
+ *
+ * Every cell keeps the elements overlapping it, ordered the same way the
+ * recursive dispatch would try them (subelements first, in order of
+ * creation). Added and moved elements are only marked dirty; the grid is
+ * updated for them on the next lookup.
+ */
+class hit_index {
+public:
+  using rect = geometry::rect;
+  using point = geometry::point;
+
+  struct entry {
+    element *target = nullptr;
+    rect bounds; // absolute, i.e. relative to the root element
+  };
+
+private:
+  element *m_root;
+  rect m_area;
+  int m_cell_size;
+  int m_columns;
+  int m_rows;
+
+  std::vector<std::vector<entry>> m_cells;
+  std::unordered_map<element *, rect> m_indexed;
+  std::unordered_set<element *> m_dirty;
+  bool m_order_dirty = true;
+
+  static bool dispatched_earlier(const entry &a, const entry &b);
+
+  // Cell coordinates are clamped, so that elements and points outside of the
+  // root area still end up in the border cells.
+  std::pair<int, int> cell_of(const point &p) const;
+  std::vector<entry> &cell(int column, int row);
+
+  void erase(element *e, const rect &bounds);
+  void insert(element *e, const rect &bounds);
+  void update_order();
+  void flush();
+
+public:
+  hit_index(element *root, int cell_size = 16);
+
+  /**
+   * Element has been added or moved.
+   */
+  void mark_dirty(element *e);
+
+  /**
+   * Element tree structure has been changed.
+   */
+  void mark_order_dirty();
+
+  /**
+   * Element is about to be destroyed.
+   */
+  void remove(element *e);
+
+  /**
+   * Get elements which might contain the point, in dispatch order. Bounds of
+   * the entries still have to be checked.
+   */
+  const std::vector<entry> &candidates(const point &p);
+};
+
+} // namespace ui
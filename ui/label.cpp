@@ -0,0 +1,48 @@
+#include "label.h"
+
+namespace ui {
+
+label::label(const rect &relative_geometry, element *superelement,
+             std::shared_ptr<font> f, const std::string &text)
+    : element(relative_geometry, superelement), m_font(std::move(f)),
+      m_text(text) {}
+
+std::shared_ptr<const text_layout> label::layout_for(int width) const {
+  return m_font->layout(m_text, m_wrap ? std::max(1, width) : 0);
+}
+
+void label::draw(painter &p) {
+  p.set_point_style(point_style_t::square, 1, true);
+  p.draw_filled_rect(geometry());
+
+  p.set_point_style(point_style_t::square, 1, false);
+  p.draw_text(*m_font, *layout_for(geometry().size().width()), {});
+}
+
+geometry::size label::measure(const size &available) {
+  return layout_for(available.width())->size;
+}
+
+void label::set_text(const std::string &text) {
+  if (text == m_text)
+    return;
+
+  m_text = text;
+  invalidate();
+  invalidate_layout();
+}
+
+const std::string &label::text() const { return m_text; }
+
+void label::set_wrap(bool wrap) {
+  if (wrap == m_wrap)
+    return;
+
+  m_wrap = wrap;
+  invalidate();
+  invalidate_layout();
+}
+
+bool label::wrap() const { return m_wrap; }
+
+} // namespace ui
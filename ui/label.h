@@ -0,0 +1,43 @@
+#pragma once
+
+#include "element.h"
+#include "font.h"
+
+namespace ui {
+
+/**
+ * Black text on white background.
+ */
+class label : public element {
+  using rect = geometry::rect;
+  using size = geometry::size;
+
+  std::shared_ptr<font> m_font;
+  std::string m_text;
+  bool m_wrap = false;
+
+  std::shared_ptr<const text_layout> layout_for(int width) const;
+
+protected:
+  void draw(painter &p) override;
+  size measure(const size &available) override;
+
+public:
+  /**
+   * @param f font, may be shared by any number of labels
+   * @param text UTF-8 text; may contain line breaks
+   */
+  label(const rect &relative_geometry, element *superelement,
+        std::shared_ptr<font> f, const std::string &text = {});
+
+  void set_text(const std::string &text);
+  const std::string &text() const;
+
+  /**
+   * Break lines between words to fit into the width of the label.
+   */
+  void set_wrap(bool wrap);
+  bool wrap() const;
+};
+
+} // namespace ui
@@ -0,0 +1,66 @@
+#include "layer_cache.h"
+
+#include <math_util.h>
+
+namespace ui {
+
+size_t layer_cache::size_of(const bitmap &b) { return b.raw_data().size(); }
+
+size_t layer_cache::size_of(const geometry::size &s) {
+  return size_t(div_ceil(s.width(), 8)) * s.height();
+}
+
+layer_cache::layer_cache(size_t budget) : m_budget(budget) {}
+
+const bitmap *layer_cache::find(element *owner) {
+  auto found = m_index.find(owner);
+  if (found == m_index.end())
+    return nullptr;
+
+  m_layers.splice(m_layers.begin(), m_layers, found->second);
+  return &found->second->image;
+}
+
+const bitmap *layer_cache::insert(element *owner, bitmap &&image) {
+  drop(owner);
+
+  auto size = size_of(image);
+  if (size > m_budget)
+    return nullptr;
+
+  while (m_used + size > m_budget)
+    drop(m_layers.back().owner);
+
+  m_layers.push_front({owner, std::move(image)});
+  m_index[owner] = m_layers.begin();
+  m_used += size;
+
+  return &m_layers.front().image;
+}
+
+void layer_cache::drop(element *owner) {
+  auto found = m_index.find(owner);
+  if (found == m_index.end())
+    return;
+
+  m_used -= size_of(found->second->image);
+  m_layers.erase(found->second);
+  m_index.erase(found);
+}
+
+void layer_cache::set_budget(size_t budget) {
+  m_budget = budget;
+
+  while (m_used > m_budget)
+    drop(m_layers.back().owner);
+}
+
+bool layer_cache::fits(const geometry::size &s) const {
+  return size_of(s) <= m_budget;
+}
+
+size_t layer_cache::budget() const { return m_budget; }
+
+size_t layer_cache::used() const { return m_used; }
+
+} // namespace ui
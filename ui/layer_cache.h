@@ -0,0 +1,75 @@
+#pragma once
+
+#include "bitmap.h"
+
+#include <list>
+#include <unordered_map>
+
+namespace ui {
+
+class element;
+
+/**
+ * Offscreen bitmaps of element subtrees which have opted in for caching (see
+ * element::set_cached), kept within a memory budget.
+ *
+ * When a new layer doesn't fit, the least recently used ones are evicted; a
+ * layer larger than the whole budget isn't cached at all.
+ */
+class layer_cache {
+  struct layer {
+    element *owner;
+    bitmap image;
+  };
+
+  size_t m_budget;
+  size_t m_used = 0;
+
+  std::list<layer> m_layers; // most recently used first
+  std::unordered_map<element *, std::list<layer>::iterator> m_index;
+
+  static size_t size_of(const bitmap &b);
+  static size_t size_of(const geometry::size &s);
+
+public:
+  static constexpr size_t default_budget = 16 * 1024;
+
+  explicit layer_cache(size_t budget = default_budget);
+
+  /**
+   * Get the layer of the element and mark it as recently used.
+   * @return layer, or nullptr if there's none
+   */
+  const bitmap *find(element *owner);
+
+  /**
+   * Could a layer of the given size be stored at all? Checked before drawing
+   * a layer, so that one which is larger than the whole budget isn't drawn
+   * offscreen only to be rejected.
+   */
+  bool fits(const geometry::size &s) const;
+
+  /**
+   * Store a layer, evicting others if necessary.
+   * @return stored layer, or nullptr if it's larger than the whole budget
+   */
+  const bitmap *insert(element *owner, bitmap &&image);
+
+  /**
+   * Forget the layer of the element, if there's one.
+   */
+  void drop(element *owner);
+
+  /**
+   * Set the memory budget in bytes, evicting layers which don't fit anymore.
+   */
+  void set_budget(size_t budget);
+  size_t budget() const;
+
+  /**
+   * Get the memory taken by the layers in bytes.
+   */
+  size_t used() const;
+};
+
+} // namespace ui
@@ -0,0 +1,198 @@
+#include "layout.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ui {
+
+box_layout::box_layout(const rect &relative_geometry, element *superelement,
+                       orientation_t orientation)
+    : element(relative_geometry, superelement), m_orientation(orientation) {}
+
+geometry::size box_layout::measure(const size &available) {
+  const size content(std::max(0, available.width() - 2 * m_padding),
+                     std::max(0, available.height() - 2 * m_padding));
+  const bool row = m_orientation == orientation_t::row;
+
+  int length = 0;
+  int thickness = 0;
+  for (auto sub : subelements()) {
+    auto [width, height] = sub->measured_size(content).dimensions();
+    length += row ? width : height;
+    thickness = std::max(thickness, row ? height : width);
+  }
+
+  if (!subelements().empty())
+    length += m_spacing * (subelements().size() - 1);
+
+  length += 2 * m_padding;
+  thickness += 2 * m_padding;
+
+  return row ? size(length, thickness) : size(thickness, length);
+}
+
+void box_layout::arrange() {
+  const auto &subs = subelements();
+  if (subs.empty())
+    return;
+
+  auto [width, height] = geometry().size().dimensions();
+  const size content(std::max(0, width - 2 * m_padding),
+                     std::max(0, height - 2 * m_padding));
+  const bool row = m_orientation == orientation_t::row;
+
+  std::vector<int> lengths;
+  lengths.reserve(subs.size());
+  int total_stretch = 0;
+  int free = row ? content.width() : content.height();
+  free -= m_spacing * (subs.size() - 1);
+
+  for (auto sub : subs) {
+    auto measured = sub->measured_size(content);
+    lengths.emplace_back(row ? measured.width() : measured.height());
+    free -= lengths.back();
+    total_stretch += std::max(0, sub->stretch());
+  }
+
+  // Integer shares which add up to exactly the free space.
+  int stretch_so_far = 0;
+  int given = 0;
+  int position = m_padding;
+
+  for (size_t i = 0; i < subs.size(); ++i) {
+    auto length = lengths[i];
+
+    if (free > 0 && total_stretch > 0 && subs[i]->stretch() > 0) {
+      stretch_so_far += subs[i]->stretch();
+      auto extra = free * stretch_so_far / total_stretch - given;
+      given += extra;
+      length += extra;
+    }
+
+    subs[i]->set_geometry(row ? rect(position, m_padding, length,
+                                     content.height())
+                              : rect(m_padding, position, content.width(),
+                                     length));
+    position += length + m_spacing;
+  }
+}
+
+void box_layout::set_spacing(int spacing) {
+  if (spacing == m_spacing)
+    return;
+
+  m_spacing = spacing;
+  request_layout();
+  invalidate_layout();
+}
+
+int box_layout::spacing() const { return m_spacing; }
+
+void box_layout::set_padding(int padding) {
+  if (padding == m_padding)
+    return;
+
+  m_padding = padding;
+  request_layout();
+  invalidate_layout();
+}
+
+int box_layout::padding() const { return m_padding; }
+
+row_layout::row_layout(const geometry::rect &relative_geometry,
+                       element *superelement)
+    : box_layout(relative_geometry, superelement, orientation_t::row) {}
+
+column_layout::column_layout(const geometry::rect &relative_geometry,
+                             element *superelement)
+    : box_layout(relative_geometry, superelement, orientation_t::column) {}
+
+grid_layout::grid_layout(const rect &relative_geometry, element *superelement,
+                         int columns)
+    : element(relative_geometry, superelement),
+      m_columns(std::max(1, columns)) {}
+
+std::vector<int> grid_layout::row_heights(const size &content) {
+  const auto &subs = subelements();
+  std::vector<int> heights((subs.size() + m_columns - 1) / m_columns, 0);
+
+  auto column_width =
+      std::max(0, (content.width() - m_spacing * (m_columns - 1)) / m_columns);
+  const size cell(column_width, content.height());
+
+  for (size_t i = 0; i < subs.size(); ++i) {
+    auto &height = heights[i / m_columns];
+    height = std::max(height, subs[i]->measured_size(cell).height());
+  }
+
+  return heights;
+}
+
+geometry::size grid_layout::measure(const size &available) {
+  const size content(std::max(0, available.width() - 2 * m_padding),
+                     std::max(0, available.height() - 2 * m_padding));
+
+  int column_width = 0;
+  auto column_available =
+      std::max(0, (content.width() - m_spacing * (m_columns - 1)) / m_columns);
+  for (auto sub : subelements())
+    column_width = std::max(
+        column_width,
+        sub->measured_size({column_available, content.height()}).width());
+
+  auto heights = row_heights(content);
+  int height = std::accumulate(heights.begin(), heights.end(), 0);
+  if (!heights.empty())
+    height += m_spacing * (heights.size() - 1);
+
+  return {m_columns * column_width + m_spacing * (m_columns - 1) +
+              2 * m_padding,
+          height + 2 * m_padding};
+}
+
+void grid_layout::arrange() {
+  const auto &subs = subelements();
+  auto [width, height] = geometry().size().dimensions();
+  const size content(std::max(0, width - 2 * m_padding),
+                     std::max(0, height - 2 * m_padding));
+
+  auto column_width =
+      std::max(0, (content.width() - m_spacing * (m_columns - 1)) / m_columns);
+  auto heights = row_heights(content);
+
+  int y = m_padding;
+  for (size_t i = 0; i < subs.size(); ++i) {
+    auto column = i % m_columns;
+    auto row = i / m_columns;
+
+    if (column == 0 && row > 0)
+      y += heights[row - 1] + m_spacing;
+
+    int x = m_padding + column * (column_width + m_spacing);
+    subs[i]->set_geometry({x, y, column_width, heights[row]});
+  }
+}
+
+void grid_layout::set_spacing(int spacing) {
+  if (spacing == m_spacing)
+    return;
+
+  m_spacing = spacing;
+  request_layout();
+  invalidate_layout();
+}
+
+int grid_layout::spacing() const { return m_spacing; }
+
+void grid_layout::set_padding(int padding) {
+  if (padding == m_padding)
+    return;
+
+  m_padding = padding;
+  request_layout();
+  invalidate_layout();
+}
+
+int grid_layout::padding() const { return m_padding; }
+
+} // namespace ui
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "element.h"
+
+namespace ui {
+
+/**
+ * Places its subelements one after another along an axis, in order of
+ * creation, each with its measured size along the axis. Free space is shared
+ * by the subelements with a non zero stretch. Across the axis, every
+ * subelement takes the whole space.
+ */
+class box_layout : public element {
+public:
+  enum class orientation_t { row, column };
+
+private:
+  using rect = geometry::rect;
+  using size = geometry::size;
+
+  orientation_t m_orientation;
+  int m_spacing = 0;
+  int m_padding = 0;
+
+protected:
+  size measure(const size &available) override;
+  void arrange() override;
+
+public:
+  box_layout(const rect &relative_geometry, element *superelement,
+             orientation_t orientation);
+
+  /**
+   * Set the gap between the subelements.
+   */
+  void set_spacing(int spacing);
+  int spacing() const;
+
+  /**
+   * Set the gap between the subelements and the edges of the layout.
+   */
+  void set_padding(int padding);
+  int padding() const;
+};
+
+/**
+ * Places its subelements from left to right.
+ */
+class row_layout : public box_layout {
+public:
+  row_layout(const geometry::rect &relative_geometry,
+             element *superelement = nullptr);
+};
+
+/**
+ * Places its subelements from top to bottom.
+ */
+class column_layout : public box_layout {
+public:
+  column_layout(const geometry::rect &relative_geometry,
+                element *superelement = nullptr);
+};
+
+/**
+ * Places its subelements in cells of a grid, row by row. All columns are of
+ * the same width, which is shared equally; every row is as high as its
+ * highest subelement. Subelements take their whole cells.
+ */
+class grid_layout : public element {
+  using rect = geometry::rect;
+  using size = geometry::size;
+
+  int m_columns;
+  int m_spacing = 0;
+  int m_padding = 0;
+
+  // Heights of the rows for the given content size
+  std::vector<int> row_heights(const size &content);
+
+protected:
+  size measure(const size &available) override;
+  void arrange() override;
+
+public:
+  grid_layout(const rect &relative_geometry, element *superelement,
+              int columns);
+
+  void set_spacing(int spacing);
+  int spacing() const;
+
+  void set_padding(int padding);
+  int padding() const;
+};
+
+} // namespace ui
@@ -0,0 +1,144 @@
+#include "list_view.h"
+
+#include <math_util.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace ui {
+
+list_view::list_view(const rect &relative_geometry, element *superelement,
+                     int row_height, row_factory factory, row_binder binder)
+    : element(relative_geometry, superelement), m_row_height(row_height),
+      m_factory(std::move(factory)), m_binder(std::move(binder)) {
+  if (m_row_height <= 0)
+    throw std::invalid_argument("Row height has to be positive");
+
+  create_rows();
+  place_rows(false);
+}
+
+void list_view::create_rows() {
+  // One more than fits, for the partially visible ones at both ends.
+  auto height = std::max(0, geometry().size().height());
+  size_t needed = div_ceil(height, m_row_height) + 1;
+  if (m_rows.size() >= needed)
+    return;
+
+  while (m_rows.size() < needed) {
+    auto row = m_factory(this);
+    if (!row || row->get_superelement() != this)
+      throw std::logic_error("Rows have to be created within the list");
+
+    m_rows.emplace_back(row);
+  }
+
+  // Items are spread over more rows now.
+  m_items.assign(m_rows.size(), no_item);
+}
+
+void list_view::place_rows(bool scrolled) {
+  auto [width, height] = geometry().size().dimensions();
+  const size_t rows = m_rows.size();
+  const size_t first = m_offset / m_row_height;
+  const int first_y = -(m_offset % m_row_height);
+
+  for (size_t item = first; item < first + rows; ++item) {
+    auto slot = item % rows;
+    auto row = m_rows[slot];
+
+    int y = first_y + int(item - first) * m_row_height;
+    bool visible = item < m_count && y < height;
+    auto bounds = visible ? rect(0, y, width, m_row_height) : rect();
+
+    // Scrolled rows are where their pixels have been shifted to.
+    if (scrolled)
+      row->relocate(bounds);
+    else
+      row->set_geometry(bounds);
+
+    if (visible && m_items[slot] != item) {
+      m_items[slot] = item;
+      m_binder(row, item);
+    }
+  }
+}
+
+void list_view::draw(painter &p) {
+  p.set_point_style(point_style_t::square, 1, true);
+  p.draw_filled_rect(geometry());
+}
+
+bool list_view::on_touch_event(const event &ev) {
+  switch (ev.type) {
+  case event::type_t::touch:
+    m_dragging = true;
+    m_drag_y = ev.y;
+    return true;
+
+  case event::type_t::drag:
+    if (!m_dragging)
+      return false;
+
+    scroll_by(m_drag_y - ev.y);
+    m_drag_y = ev.y;
+    return true;
+
+  case event::type_t::release:
+    m_dragging = false;
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+void list_view::arrange() {
+  create_rows();
+  m_offset = std::min(m_offset, max_offset());
+  place_rows(false);
+}
+
+void list_view::set_count(size_t count) {
+  m_count = count;
+  m_offset = std::min(m_offset, max_offset());
+  m_items.assign(m_rows.size(), no_item);
+
+  invalidate();
+  place_rows(false);
+}
+
+size_t list_view::count() const { return m_count; }
+
+void list_view::refresh(size_t item) {
+  if (m_rows.empty())
+    return;
+
+  auto slot = item % m_rows.size();
+  if (m_items[slot] != item)
+    return; // not visible
+
+  m_binder(m_rows[slot], item);
+  m_rows[slot]->invalidate();
+}
+
+void list_view::scroll_to(int offset) {
+  offset = std::clamp(offset, 0, max_offset());
+  if (offset == m_offset)
+    return;
+
+  scroll_area(geometry(), m_offset - offset);
+  m_offset = offset;
+  place_rows(true);
+}
+
+void list_view::scroll_by(int dy) { scroll_to(m_offset + dy); }
+
+int list_view::offset() const { return m_offset; }
+
+int list_view::max_offset() {
+  auto content = int64_t(m_count) * m_row_height;
+  return std::max<int64_t>(0, content - geometry().size().height());
+}
+
+} // namespace ui
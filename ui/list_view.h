@@ -0,0 +1,86 @@
+#pragma once
+
+#include "element.h"
+
+#include <functional>
+
+namespace ui {
+
+/**
+ * Vertical, scrollable list of items, each shown in a row of the same height.
+ *
+ * Items come from a data source: the list only knows their count, and asks
+ * the binder to show an item in a row. Rows are created by the factory for
+ * the visible part of the list only, and get reused for other items as the
+ * list scrolls.
+ *
+ * Scrolling shifts the pixels which are already drawn, so that only the
+ * strip which gets uncovered is drawn again (see element::scroll_area). The
+ * list must not be overlapped by other elements for that reason.
+ */
+class list_view : public element {
+public:
+  /**
+   * Create a row element within the list; it has to be created in the same
+   * arena as the list, if the list lives in one.
+   */
+  using row_factory = std::function<element *(list_view *list)>;
+
+  /**
+   * Show an item in a row created by the factory.
+   */
+  using row_binder = std::function<void(element *row, size_t item)>;
+
+private:
+  using rect = geometry::rect;
+
+  static constexpr size_t no_item = -1;
+
+  int m_row_height;
+  row_factory m_factory;
+  row_binder m_binder;
+
+  size_t m_count = 0;
+  int m_offset = 0;
+
+  // Item i is shown by the row i % m_rows.size(); items of the rows tell
+  // which ones have to be bound again.
+  std::vector<element *> m_rows;
+  std::vector<size_t> m_items;
+
+  bool m_dragging = false;
+  int m_drag_y = 0;
+
+  void create_rows();
+  void place_rows(bool scrolled);
+
+protected:
+  void draw(painter &p) override;
+  bool on_touch_event(const event &ev) override;
+  void arrange() override;
+
+public:
+  list_view(const rect &relative_geometry, element *superelement,
+            int row_height, row_factory factory, row_binder binder);
+
+  /**
+   * Set the number of items; every visible row gets bound again.
+   */
+  void set_count(size_t count);
+  size_t count() const;
+
+  /**
+   * The item has changed; bind it again if it's visible.
+   */
+  void refresh(size_t item);
+
+  /**
+   * Scroll to an offset from the top of the first item, in pixels.
+   */
+  void scroll_to(int offset);
+  void scroll_by(int dy);
+  int offset() const;
+  int max_offset();
+};
+
+} // namespace ui
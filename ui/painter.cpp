@@ -1,13 +1,236 @@
 #include "painter.h"
 
+#include "font.h"
+#include "span.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <tuple>
+
 namespace ui {
 
+// Visit the pixels of a one pixel wide line with Bresenham's algorithm, from
+// the start to the end inclusive, using integer arithmetic only; the visitor
+// returns false to stop early.
+template <typename Visit>
+static void trace_line(int x1, int y1, int x2, int y2, Visit &&visit) {
+  const int dx = std::abs(x2 - x1);
+  const int dy = -std::abs(y2 - y1);
+  const int step_x = x1 < x2 ? 1 : -1;
+  const int step_y = y1 < y2 ? 1 : -1;
+  int error = dx + dy;
+
+  while (true) {
+    if (!visit(x1, y1) || (x1 == x2 && y1 == y2))
+      return;
+
+    int doubled = 2 * error;
+    if (doubled >= dy) {
+      error += dy;
+      x1 += step_x;
+    }
+    if (doubled <= dx) {
+      error += dx;
+      y1 += step_y;
+    }
+  }
+}
+
+painter::painter(bitmap &b) : painter(b, b.geometry(), b.geometry()) {}
+
 painter::painter(bitmap &b, const rect &draw_area)
-    : m_bitmap(b), m_translated_geometry(b.geometry().overlap(draw_area)),
-      m_geometry(m_translated_geometry) {
-  m_geometry.set_position({});
+    : painter(b, draw_area, b.geometry()) {}
+
+painter::painter(bitmap &b, const rect &draw_area, const rect &clip)
+    : m_bitmap(b), m_origin(draw_area.top_left()),
+      m_geometry(b.geometry().overlap(draw_area).overlap(clip)) {
+  m_geometry.move(-m_origin.x(), -m_origin.y());
+  m_saved.reserve(16);
+  update_clip_bounds();
+}
+
+void painter::update_clip_bounds() {
+  std::tie(m_clip_min_x, m_clip_min_y) = m_geometry.top_left().coords();
+  std::tie(m_clip_max_x, m_clip_max_y) = m_geometry.bottom_right().coords();
+}
+
+bool painter::clipped(int x, int y) const {
+  return x < m_clip_min_x || x >= m_clip_max_x || y < m_clip_min_y ||
+         y >= m_clip_max_y;
+}
+
+std::pair<int, int> painter::clip_rows(int begin_y, int end_y) const {
+  return {std::max(begin_y, m_clip_min_y), std::min(end_y, m_clip_max_y)};
+}
+
+// Half widths of the rows of a disc: the row dy from the centre spans
+// [-half[|dy|], half[|dy|]], for |dy| < radius. As in the midpoint algorithm,
+// the half width only ever shrinks away from the centre, so it's found by
+// stepping it down instead of with a square root.
+static void disc_rows(int radius, std::vector<int> &half) {
+  half.resize(std::max(radius, 0));
+
+  int k = radius - 1;
+  for (int dy = 0; dy < radius; ++dy) {
+    while (k * k + dy * dy >= radius * radius)
+      --k;
+    half[dy] = k;
+  }
+}
+
+// Insets of the rows of an ellipse inscribed into a width x height box, from
+// both sides of the box. In doubled coordinates relative to the centre of the
+// box, a pixel at (u, v) is inside if (u / width)^2 + (v / height)^2 <= 1;
+// u steps by 2 from pixel to pixel.
+static void ellipse_rows(int width, int height, std::vector<int> &insets) {
+  insets.assign(std::max(height, 0), 0);
+  if (width <= 0 || height <= 0)
+    return;
+
+  const int64_t w2 = int64_t(width) * width;
+  const int64_t h2 = int64_t(height) * height;
+  int64_t u = width - 1;
+
+  for (int row = height / 2; row < height; ++row) {
+    int64_t v = 2 * row + 1 - height;
+    while (u >= 0 && u * u * h2 + v * v * w2 > w2 * h2)
+      u -= 2;
+
+    insets[row] = insets[height - 1 - row] =
+        u >= 0 ? (width - 1 - u) / 2 : (width + 1) / 2;
+  }
+}
+
+// Insets of the rows of a rounded rectangle; its corners are quadrants of the
+// circle inscribed into a square with a side of twice the corner radius.
+static void rounded_rect_rows(int width, int height, int corner,
+                              std::vector<int> &insets) {
+  insets.assign(std::max(height, 0), 0);
+  corner = std::min({corner, width / 2, height / 2});
+  if (corner <= 0)
+    return;
+
+  const int64_t side = 2 * corner;
+  int64_t u = side - 1;
+
+  for (int row = corner; row < side; ++row) {
+    int64_t v = 2 * row + 1 - side;
+    while (u >= 0 && u * u + v * v > side * side)
+      u -= 2;
+
+    insets[side - 1 - row] = insets[height - side + row] =
+        u >= 0 ? (side - 1 - u) / 2 : corner;
+  }
+}
+
+void painter::update_fill(const fill_style &fill) {
+  m_fill = fill;
+  m_anchored_tile = fill.tile.shifted(fill.origin.x(), fill.origin.y());
+}
+
+uint8_t painter::fill_byte(int bitmap_y) const {
+  if (m_fill.patterned)
+    return m_anchored_tile.row(bitmap_y);
+
+  return m_point_style.white ? 0xff : 0x00;
+}
+
+void painter::fill_row(int y, int begin_x, int end_x) {
+  begin_x = std::max(begin_x, m_clip_min_x);
+  end_x = std::min(end_x, m_clip_max_x);
+  if (begin_x >= end_x)
+    return;
+
+  // The clip area is within the bitmap.
+  const int bitmap_y = m_origin.y() + y;
+  fill_span(m_bitmap.row_unchecked(bitmap_y), m_origin.x() + begin_x,
+            m_origin.x() + end_x, fill_byte(bitmap_y));
+}
+
+void painter::fill_shape(const rect &bounds, const std::vector<int> &insets) {
+  auto [x, y] = bounds.pos().coords();
+  const int width = bounds.size().width();
+  auto [first, last] = clip_rows(y, y + int(insets.size()));
+
+  for (int row = first - y; row < last - y; ++row)
+    fill_row(y + row, x + insets[row], x + width - insets[row]);
+}
+
+void painter::fill_shape_outline(const rect &outer,
+                                 const std::vector<int> &outer_insets,
+                                 const rect &inner,
+                                 const std::vector<int> &inner_insets) {
+  auto [outer_x, outer_y] = outer.pos().coords();
+  auto [inner_x, inner_y] = inner.pos().coords();
+  const int outer_width = outer.size().width();
+  const int inner_width = inner.size().width();
+  auto [first, last] =
+      clip_rows(outer_y, outer_y + int(outer_insets.size()));
+
+  for (int row = first - outer_y; row < last - outer_y; ++row) {
+    const int y = outer_y + row;
+    const int begin = outer_x + outer_insets[row];
+    const int end = outer_x + outer_width - outer_insets[row];
+
+    // Everything but the span of the inner shape, if it has any in the row.
+    const int inner_row = y - inner_y;
+    if (inner_width > 0 && inner_row >= 0 &&
+        inner_row < int(inner_insets.size())) {
+      const int hole_begin = inner_x + inner_insets[inner_row];
+      const int hole_end = inner_x + inner_width - inner_insets[inner_row];
+
+      if (hole_begin < hole_end) {
+        fill_row(y, begin, std::min(hole_begin, end));
+        fill_row(y, std::max(hole_end, begin), end);
+        continue;
+      }
+    }
+
+    fill_row(y, begin, end);
+  }
+}
+
+void painter::save() {
+  m_saved.push_back({m_origin, m_geometry, m_point_style, m_fill});
+}
+
+void painter::restore() {
+  if (m_saved.empty())
+    throw std::logic_error("painter::restore without painter::save");
+
+  const auto &saved = m_saved.back();
+  m_origin = saved.origin;
+  m_geometry = saved.clip;
+  m_point_style = saved.point_style;
+  update_fill(saved.fill);
+  m_saved.pop_back();
+
+  update_clip_bounds();
+}
+
+void painter::translate(int dx, int dy) {
+  m_origin = m_origin + point(dx, dy);
+  m_geometry.move(-dx, -dy);
+  update_clip_bounds();
 }
 
+void painter::translate(const point &d) { translate(d.x(), d.y()); }
+
+void painter::clip(const rect &r) {
+  // Keep an empty clip area where it was instead of overlap's zero rect.
+  if (m_geometry.overlap(r).area() == 0)
+    m_geometry.set_size(0, 0);
+  else
+    m_geometry = m_geometry.overlap(r);
+
+  update_clip_bounds();
+}
+
+geometry::rect painter::clip_rect() const { return m_geometry; }
+
 void painter::set_point_style(point_style_t::shape_t shape, uint radius,
                               bool white) {
   m_point_style = {shape, radius, white};
@@ -17,27 +240,42 @@ void painter::set_point_style(point_style_t style) { m_point_style = style; }
 
 point_style_t painter::point_style() const { return m_point_style; }
 
-bool painter::pixel(const point &p) const { return m_bitmap.pixel(p); }
+void painter::set_fill_pattern(const pattern &p) {
+  update_fill({true, p, m_fill.origin});
+}
+
+void painter::set_solid_fill() { m_fill.patterned = false; }
 
-bool painter::pixel(uint x, uint y) const { return m_bitmap.pixel(x, y); }
+void painter::set_pattern_origin(const point &p) {
+  update_fill({m_fill.patterned, m_fill.tile, p + m_origin});
+}
+
+bool painter::pixel(const point &p) const {
+  return m_bitmap.pixel(p + m_origin);
+}
+
+bool painter::pixel(uint x, uint y) const {
+  return m_bitmap.pixel(m_origin.x() + x, m_origin.y() + y);
+}
 
 void painter::draw_pixel(const point &p, bool white) {
-  m_bitmap.draw_pixel(p + m_translated_geometry.top_left(), white);
+  draw_pixel(p.x(), p.y(), white);
 }
 
 void painter::draw_pixel(uint x, uint y, bool white) {
-  auto [translated_x, translated_y] = m_translated_geometry.top_left().coords();
-  m_bitmap.draw_pixel(translated_x + x, translated_y + y, white);
+  if (clipped(x, y))
+    return;
+
+  m_bitmap.draw_pixel_unchecked(m_origin.x() + x, m_origin.y() + y, white);
 }
 
 void painter::draw_filled_rect(const rect &r) {
   auto bounds = m_geometry.overlap(r);
-  auto [min_x, min_y] = bounds.top_left().coords();
-  auto [max_x, max_y] = bounds.bottom_right().coords();
-
-  for (int y = min_y; y < max_y; ++y)
-    for (int x = min_x; x < max_x; ++x)
-      draw_pixel(x, y, m_point_style.white);
+  bounds.move(m_origin.x(), m_origin.y());
+  if (m_fill.patterned)
+    m_bitmap.fill(bounds, m_anchored_tile);
+  else
+    m_bitmap.fill(bounds, m_point_style.white ? 0xff : 0x00);
 }
 
 void painter::draw_filled_rect(int x1, int y1, int x2, int y2) {
@@ -47,9 +285,27 @@ void painter::draw_filled_rect(int x1, int y1, int x2, int y2) {
 void painter::draw_rect_outline(const rect &r) {
   auto vertices = r.vertices();
 
-  for (int edge = 0; edge < vertices.size() - 1; ++edge)
-    draw_line(vertices[edge], vertices[edge + 1]);
-  draw_line(vertices[vertices.size() - 1], vertices[0]);
+  if (m_point_style.shape != point_style_t::square) {
+    for (int edge = 0; edge < vertices.size() - 1; ++edge)
+      draw_line(vertices[edge], vertices[edge + 1]);
+    draw_line(vertices[vertices.size() - 1], vertices[0]);
+    return;
+  }
+
+  // Edges drawn with a square pen are rectangles; the horizontal ones take
+  // the corners.
+  const int pen = m_point_style.radius;
+  auto [left, top] = r.top_left().coords();
+  auto [right, bottom] = r.bottom_right().coords();
+  const int width = right - left + 2 * pen;
+  const int side = bottom - top - 2 * pen;
+
+  draw_filled_rect({left - pen, top - pen, width, 2 * pen});
+  draw_filled_rect({left - pen, bottom - pen, width, 2 * pen});
+  if (side > 0) {
+    draw_filled_rect({left - pen, top + pen, 2 * pen, side});
+    draw_filled_rect({right - pen, top + pen, 2 * pen, side});
+  }
 }
 
 void painter::draw_rect_outline(int x1, int y1, int x2, int y2) {
@@ -61,20 +317,132 @@ void painter::draw_filled_circle(const point &p, uint radius) {
 }
 
 void painter::draw_filled_circle(int x, int y, uint radius) {
-  int radius_squared = radius * radius;
-  int radius_doubled = radius << 1; // var << 1 == var / 2;
-  int area = radius_squared << 2;
+  const int r = radius;
+  disc_rows(r, m_outer_rows);
+  auto [first, last] = clip_rows(y + 1 - r, y + r);
+
+  for (int dy = first - y; dy < last - y; ++dy) {
+    int half = m_outer_rows[std::abs(dy)];
+    fill_row(y + dy, x - half, x + half + 1);
+  }
+}
+
+void painter::draw_circle_outline(const point &p, uint radius) {
+  // Every angle, i.e. both halves of the circle.
+  draw_arc(p, radius, 0, 360);
+}
 
-  for (int i = 0; i < area; i++) {
-    auto div = std::div(i, radius_doubled);
-    int delta_x = div.rem - radius;
-    int delta_y = div.quot - radius;
+void painter::draw_arc(const point &p, uint radius, int start_angle,
+                       int end_angle) {
+  if (end_angle == start_angle)
+    return;
+
+  const int pen = m_point_style.radius;
+  const int outer = radius + pen;
+  const int inner = std::max<int>(radius - pen, 0);
+  disc_rows(outer, m_outer_rows);
+  disc_rows(inner, m_inner_rows);
+
+  // Directions of the ends of the arc, with y pointing up; a pixel is within
+  // the arc if it's counterclockwise from the start and clockwise from the
+  // end, or not clockwise from the start and counterclockwise from the end
+  // if the arc spans more than a half circle.
+  const bool whole = std::abs(end_angle - start_angle) >= 360;
+  const int sweep = ((end_angle - start_angle) % 360 + 360) % 360;
+  auto direction = [](int angle) {
+    double radians = angle * std::numbers::pi / 180;
+    return std::pair<int64_t, int64_t>(std::lround(4096 * std::cos(radians)),
+                                       std::lround(4096 * std::sin(radians)));
+  };
+  const auto [start_x, start_y] = direction(start_angle);
+  const auto [end_x, end_y] = direction(end_angle);
+
+  auto within = [&](int64_t dx, int64_t dy) {
+    if (whole)
+      return true;
+
+    dy = -dy;
+    bool after_start = start_x * dy - start_y * dx >= 0;
+    bool before_end = dx * end_y - dy * end_x >= 0;
+    return sweep <= 180 ? after_start && before_end
+                        : after_start || before_end;
+  };
+
+  // Pixels within the arc, out of a span of the ring
+  auto fill_arc = [&](int dy, int begin, int end) {
+    int run = begin;
+    for (int dx = begin; dx < end; ++dx)
+      if (!within(dx, dy)) {
+        fill_row(p.y() + dy, p.x() + run, p.x() + dx);
+        run = dx + 1;
+      }
+    fill_row(p.y() + dy, p.x() + run, p.x() + end);
+  };
+
+  auto [first, last] = clip_rows(p.y() + 1 - outer, p.y() + outer);
+  for (int dy = first - p.y(); dy < last - p.y(); ++dy) {
+    const int outer_half = m_outer_rows[std::abs(dy)];
+    if (std::abs(dy) >= inner) {
+      fill_arc(dy, -outer_half, outer_half + 1);
+      continue;
+    }
 
-    if (delta_x * delta_x + delta_y * delta_y < radius_squared)
-      draw_pixel(x + delta_x, y + delta_y, m_point_style.white);
+    const int inner_half = m_inner_rows[std::abs(dy)];
+    fill_arc(dy, -outer_half, -inner_half);
+    fill_arc(dy, inner_half + 1, outer_half + 1);
   }
 }
 
+void painter::draw_filled_ellipse(const rect &bounds) {
+  auto [width, height] = bounds.size().dimensions();
+  ellipse_rows(width, height, m_outer_rows);
+  fill_shape(bounds, m_outer_rows);
+}
+
+void painter::draw_ellipse_outline(const rect &bounds) {
+  const int pen = m_point_style.radius;
+  auto [x, y] = bounds.pos().coords();
+  auto [width, height] = bounds.size().dimensions();
+
+  // rect would turn a negative size of a thin ellipse's inside around.
+  const rect outer(x - pen, y - pen, width + 2 * pen, height + 2 * pen);
+  const int inner_width = width - 2 * pen;
+  const int inner_height = height - 2 * pen;
+  const rect inner = inner_width > 0 && inner_height > 0
+                         ? rect(x + pen, y + pen, inner_width, inner_height)
+                         : rect();
+
+  ellipse_rows(outer.size().width(), outer.size().height(), m_outer_rows);
+  ellipse_rows(inner.size().width(), inner.size().height(), m_inner_rows);
+  fill_shape_outline(outer, m_outer_rows, inner, m_inner_rows);
+}
+
+void painter::draw_filled_rounded_rect(const rect &r, uint corner_radius) {
+  auto [width, height] = r.size().dimensions();
+  rounded_rect_rows(width, height, corner_radius, m_outer_rows);
+  fill_shape(r, m_outer_rows);
+}
+
+void painter::draw_rounded_rect_outline(const rect &r, uint corner_radius) {
+  const int pen = m_point_style.radius;
+  auto [x, y] = r.pos().coords();
+  auto [width, height] = r.size().dimensions();
+
+  const rect outer(x - pen, y - pen, width + 2 * pen, height + 2 * pen);
+  const int inner_width = width - 2 * pen;
+  const int inner_height = height - 2 * pen;
+  const rect inner = inner_width > 0 && inner_height > 0
+                         ? rect(x + pen, y + pen, inner_width, inner_height)
+                         : rect();
+
+  // Square corners stay square on the outside as well.
+  rounded_rect_rows(outer.size().width(), outer.size().height(),
+                    corner_radius > 0 ? corner_radius + pen : 0, m_outer_rows);
+  rounded_rect_rows(inner.size().width(), inner.size().height(),
+                    std::max<int>(corner_radius - pen, 0), m_inner_rows);
+  fill_shape_outline(outer, m_outer_rows, inner, m_inner_rows);
+}
+
 void painter::draw_point(const point &p) {
   switch (m_point_style.shape) {
   case point_style_t::round: {
@@ -95,25 +463,102 @@ void painter::draw_point(const point &p) {
   }
 }
 
+void painter::draw_text(const font &f, const text_layout &text,
+                        const point &to) {
+  auto clip = m_geometry;
+  clip.move(m_origin.x(), m_origin.y());
+  f.draw(m_bitmap, clip, to + m_origin, text, m_point_style.white);
+}
+
+void painter::draw_bitmap(const bitmap &b, const point &to, raster_op op,
+                          const bitmap *mask) {
+  auto area = m_geometry.overlap({to, b.geometry().size()});
+  if (area.area() == 0)
+    return;
+
+  auto src_area = area;
+  src_area.move(-to.x(), -to.y());
+  blit(b, src_area, m_bitmap, area.pos() + m_origin, op, mask);
+}
+
 void painter::draw_line(const line &line) {
   const auto [begin, end] = line.points_ref();
   auto [x1, y1] = begin.coords();
   auto [x2, y2] = end.coords();
 
-  if (std::abs(x1 - x2) > std::abs(y1 - y2)) {
-    auto direction = x1 < x2 ? 1 : -1;
-    for (int x = x1; x != x2; x += direction) {
-      const point p{x, line.resolve_y(x)};
-      if (m_geometry.contains(p))
-        draw_point(p);
+  // A square pen covers [-pen, pen) around every pixel of the line, a round
+  // one the disc of painter::draw_filled_circle.
+  const bool square = m_point_style.shape == point_style_t::square;
+  const int pen = m_point_style.radius;
+  if (pen == 0)
+    return;
+
+  if (square && (y1 == y2 || x1 == x2)) {
+    auto [left, right] = std::minmax(x1, x2);
+    auto [top, bottom] = std::minmax(y1, y2);
+    draw_filled_rect({left - pen, top - pen, right - left + 2 * pen,
+                      bottom - top + 2 * pen});
+    return;
+  }
+
+  if (y1 > y2) {
+    std::swap(x1, x2);
+    std::swap(y1, y2);
+  }
+
+  // Nothing to do if the box swept by the pen misses the clip area.
+  auto [min_x, max_x] = std::minmax(x1, x2);
+  if (max_x + pen < m_clip_min_x || min_x - pen >= m_clip_max_x ||
+      y2 + pen < m_clip_min_y || y1 - pen >= m_clip_max_y)
+    return;
+
+  // Bounds of the one pixel wide line in every row; x only ever goes one
+  // way, so that they're monotonic from row to row. Rows below the ones the
+  // pen reaches the clip area from aren't traced.
+  const int last_row = std::min(y2, m_clip_max_y - 1 + pen);
+  m_line_rows.assign(last_row - y1 + 1, {INT_MAX, INT_MIN});
+  trace_line(x1, y1, x2, y2, [this, y1, last_row](int x, int y) {
+    if (y > last_row)
+      return false;
+
+    auto &[left, right] = m_line_rows[y - y1];
+    left = std::min(left, x);
+    right = std::max(right, x);
+    return true;
+  });
+
+  if (square) {
+    // Pixels of a row are covered by the pen at the line rows within
+    // (y - pen, y + pen]; thanks to the monotony, the span of the row is
+    // given by the first and the last of them.
+    auto [first, last] = clip_rows(y1 - pen, y2 + pen);
+    for (int y = first; y < last; ++y) {
+      const auto &first = m_line_rows[std::max(y - pen + 1, y1) - y1];
+      const auto &last = m_line_rows[std::min(y + pen, y2) - y1];
+      fill_row(y, std::min(first.first, last.first) - pen,
+               std::max(first.second, last.second) + pen);
     }
-  } else {
-    auto direction = y1 < y2 ? 1 : -1;
-    for (int y = y1; y != y2; y += direction) {
-      const point p{line.resolve_x(y), y};
-      if (m_geometry.contains(p))
-        draw_point(p);
+
+    return;
+  }
+
+  // The discs along the line make up a capsule, so every row of it is a
+  // single span: the union of the disc rows of the line rows within
+  // (y - pen, y + pen).
+  disc_rows(pen, m_outer_rows);
+  auto [first, last] = clip_rows(y1 - pen + 1, y2 + pen);
+  for (int y = first; y < last; ++y) {
+    int left = INT_MAX;
+    int right = INT_MIN;
+    for (int line_y = std::max(y - pen + 1, y1);
+         line_y <= std::min(y + pen - 1, y2); ++line_y) {
+      const auto &[line_left, line_right] = m_line_rows[line_y - y1];
+      const int half = m_outer_rows[std::abs(y - line_y)];
+      left = std::min(left, line_left - half);
+      right = std::max(right, line_right + half);
     }
+
+    fill_row(y, left, right + 1);
   }
 }
 
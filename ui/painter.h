@@ -2,9 +2,16 @@
 
 #include "../geometry/line.h"
 #include "bitmap.h"
+#include "blit.h"
+#include "pattern.h"
+
+#include <vector>
 
 namespace ui {
 
+class font;
+struct text_layout;
+
 struct point_style_t {
   enum shape_t { round, square };
   shape_t shape = square;
@@ -16,23 +23,122 @@ struct point_style_t {
       : shape(shape), radius(radius), white(white) {}
 };
 
+/**
+ * Draws onto a bitmap in coordinates relative to a movable origin, limited to
+ * a clip area.
+ *
+ * The origin, the clip area and the point style can be saved and restored,
+ * so that a single painter can be passed down a whole element tree: every
+ * element translates and clips it to itself, draws, and restores it for the
+ * next one.
+ */
 class painter {
   using rect = geometry::rect;
   using point = geometry::point;
   using line = geometry::line;
 
+  // Pattern to fill with instead of the point style's color, if any
+  struct fill_style {
+    bool patterned = false;
+    pattern tile = pattern::solid(false);
+    point origin; // within the bitmap
+  };
+
+  struct state {
+    point origin;
+    rect clip;
+    point_style_t point_style;
+    fill_style fill;
+  };
+
   bitmap &m_bitmap;
-  rect m_translated_geometry;
-  rect m_geometry;
+  point m_origin;  // origin within the bitmap
+  rect m_geometry; // clip area, relative to the origin
   point_style_t m_point_style;
+  fill_style m_fill;
+  pattern m_anchored_tile = pattern::solid(false); // shifted to its origin
+  std::vector<state> m_saved;
+
+  // m_geometry bounds, which primitives are clipped to up front
+  int m_clip_min_x, m_clip_min_y, m_clip_max_x, m_clip_max_y;
+
+  // Leftmost and rightmost pixel of every row of a line, and insets of the
+  // rows of shapes from their bounds; reused by all primitives
+  std::vector<std::pair<int, int>> m_line_rows;
+  std::vector<int> m_outer_rows;
+  std::vector<int> m_inner_rows;
+
+  void update_clip_bounds();
+  void update_fill(const fill_style &fill);
+  uint8_t fill_byte(int bitmap_y) const;
+  bool clipped(int x, int y) const;
+  std::pair<int, int> clip_rows(int begin_y, int end_y) const;
+
+  // Fill a span of a row within the clip rows, clipping the span only.
+  void fill_row(int y, int begin_x, int end_x);
+  void fill_shape(const rect &bounds, const std::vector<int> &insets);
+  void fill_shape_outline(const rect &outer,
+                          const std::vector<int> &outer_insets,
+                          const rect &inner,
+                          const std::vector<int> &inner_insets);
 
 public:
+  explicit painter(bitmap &b);
   painter(bitmap &b, const rect &draw_area);
 
+  /**
+   * @param draw_area area within the bitmap the coordinates are relative to
+   * @param clip area within the bitmap to limit the drawing to
+   */
+  painter(bitmap &b, const rect &draw_area, const rect &clip);
+
+  /**
+   * Push the origin, the clip area, the point style and the fill onto a
+   * stack.
+   */
+  void save();
+
+  /**
+   * Pop the state pushed by the matching painter::save.
+   */
+  void restore();
+
+  /**
+   * Move the origin by dx, dy.
+   */
+  void translate(int dx, int dy);
+  void translate(const point &d);
+
+  /**
+   * Limit the drawing to the intersection of the current clip area and r.
+   * @param r area relative to the current origin
+   */
+  void clip(const rect &r);
+
+  /**
+   * Get the current clip area, relative to the current origin.
+   */
+  rect clip_rect() const;
+
   void set_point_style(point_style_t::shape_t shape, uint radius, bool white);
   void set_point_style(point_style_t style);
   point_style_t point_style() const;
 
+  /**
+   * Fill with a pattern instead of the point style's color, until
+   * painter::set_solid_fill. It applies to everything but text and bitmaps,
+   * and costs the same as a solid fill.
+   */
+  void set_fill_pattern(const pattern &p);
+  void set_solid_fill();
+
+  /**
+   * Anchor the pattern to a point instead of the top left corner of the
+   * bitmap, e.g. to have it move along with the contents of an element.
+   * @param p point relative to the current origin
+   */
+  void set_pattern_origin(const point &p);
+
   bool pixel(const point &p) const;
   bool pixel(uint x, uint y) const;
 
@@ -45,12 +151,72 @@ public:
   void draw_rect_outline(const rect &r);
   void draw_rect_outline(int x1, int y1, int x2, int y2);
 
+  /**
+   * Draw a disc of the pixels closer than the radius to the centre.
+   */
   void draw_filled_circle(const point &p, uint radius);
   void draw_filled_circle(int x, int y, uint radius);
 
+  /**
+   * Draw a circle with the point style's radius as the half width of the
+   * ring, i.e. with every pixel between radius - pen and radius + pen from
+   * the centre.
+   */
+  void draw_circle_outline(const point &p, uint radius);
+
+  /**
+   * Draw a part of a circle outline, counterclockwise from the start to the
+   * end angle.
+   * @param start_angle in degrees; 0 points right, 90 up
+   */
+  void draw_arc(const point &p, uint radius, int start_angle, int end_angle);
+
+  /**
+   * Draw an ellipse inscribed into the rectangle.
+   */
+  void draw_filled_ellipse(const rect &bounds);
+
+  /**
+   * Draw an ellipse outline; the pen is centred on the ellipse the same way
+   * as on the edges of painter::draw_rect_outline.
+   */
+  void draw_ellipse_outline(const rect &bounds);
+
+  /**
+   * Draw a rectangle with its corners rounded to quarter circles.
+   */
+  void draw_filled_rounded_rect(const rect &r, uint corner_radius);
+
+  /**
+   * Draw a rounded rectangle outline; without rounding, it's the same as
+   * painter::draw_rect_outline.
+   */
+  void draw_rounded_rect_outline(const rect &r, uint corner_radius);
+
   void draw_point(const point &p);
   void draw_point(uint x, uint y);
 
+  /**
+   * Draw text laid out with font::layout, with its top left corner at the
+   * given point; white text if the point style says so.
+   */
+  void draw_text(const font &f, const text_layout &text, const point &to);
+
+  /**
+   * Draw a bitmap with its top left corner at the given point.
+   * @param op how to combine its pixels with the ones drawn already
+   * @param mask bitmap of the size of b; only pixels where it's white are
+   * drawn, if given
+   */
+  void draw_bitmap(const bitmap &b, const point &to,
+                   raster_op op = raster_op::copy,
+                   const bitmap *mask = nullptr);
+
+  /**
+   * Draw a line with the point style, from the start to the end point
+   * inclusive. Every pixel is drawn once: the square pen sweeps a
+   * parallelogram, and the round one a capsule.
+   */
   void draw_line(const line &line);
   void draw_line(const point &start, const point &end);
   void draw_line(int x1, int y1, int x2, int y2);
@@ -0,0 +1,92 @@
+#include "pattern.h"
+
+#include <bit>
+#include <stdexcept>
+
+namespace ui {
+
+// Order in which the pixels of a tile turn white as the gray level rises:
+// the 8x8 Bayer matrix, i.e. the 2x2 one (0 2 / 3 1) at every scale, with
+// the finest scale as the most significant digit so that neighbours are far
+// apart in the order.
+static constexpr std::array<std::array<uint8_t, 8>, 8> bayer_matrix() {
+  std::array<std::array<uint8_t, 8>, 8> matrix{};
+
+  for (int y = 0; y < 8; ++y)
+    for (int x = 0; x < 8; ++x) {
+      int value = 0;
+      for (int bit = 0; bit < 3; ++bit) {
+        const int bx = (x >> bit) & 1;
+        const int by = (y >> bit) & 1;
+        value = value * 4 + ((bx ^ by) << 1 | by);
+      }
+      matrix[y][x] = value;
+    }
+
+  return matrix;
+}
+
+static constexpr auto bayer = bayer_matrix();
+
+pattern::pattern(const std::array<uint8_t, 8> &rows) : m_rows(rows) {}
+
+pattern pattern::solid(bool white) {
+  std::array<uint8_t, 8> rows;
+  rows.fill(white ? 0xff : 0x00);
+  return pattern(rows);
+}
+
+pattern pattern::gray(int level) {
+  if (level < 0 || level > max_gray_level)
+    throw std::invalid_argument("Gray level out of range");
+
+  std::array<uint8_t, 8> rows{};
+  for (int y = 0; y < 8; ++y)
+    for (int x = 0; x < 8; ++x)
+      if (bayer[y][x] < level)
+        rows[y] |= 0x80 >> x;
+
+  return pattern(rows);
+}
+
+pattern pattern::hatching(hatch h) {
+  std::array<uint8_t, 8> rows;
+  rows.fill(0xff);
+
+  for (int y = 0; y < 8; ++y) {
+    const bool horizontal = h == hatch::horizontal || h == hatch::cross;
+    const bool vertical = h == hatch::vertical || h == hatch::cross;
+    const bool diagonal = h == hatch::diagonal || h == hatch::diagonal_cross;
+    const bool anti_diagonal =
+        h == hatch::anti_diagonal || h == hatch::diagonal_cross;
+
+    if (horizontal && y == 0)
+      rows[y] = 0x00;
+    if (vertical)
+      rows[y] &= 0x7f;
+    if (diagonal)
+      rows[y] &= ~(0x80 >> y);
+    if (anti_diagonal)
+      rows[y] &= ~(0x01 << y);
+  }
+
+  return pattern(rows);
+}
+
+pattern pattern::inverted() const {
+  auto rows = m_rows;
+  for (auto &row : rows)
+    row = ~row;
+  return pattern(rows);
+}
+
+pattern pattern::shifted(int dx, int dy) const {
+  // Pixel x takes the column x - dx of the tile, i.e. every row is rotated
+  // right by dx.
+  std::array<uint8_t, 8> rows;
+  for (int y = 0; y < 8; ++y)
+    rows[y] = std::rotr(row(y - dy), dx & 7);
+  return pattern(rows);
+}
+
+} // namespace ui
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace ui {
+
+/**
+ * 8x8 tile of pixels repeated over an area, for the shades of gray a 1 bit
+ * panel can't show otherwise.
+ *
+ * A row of the tile is a byte, laid out like the bytes of a bitmap row:
+ * pixel (x, y) gets bit 7 - x % 8 of row y % 8, and set bits are white.
+ * Patterns are anchored to the top left corner of the bitmap, so that fills
+ * next to each other tile seamlessly, and a row of a fill is a single byte
+ * repeated along it, as fast to write as a solid color (see ui::fill_span).
+ */
+class pattern {
+public:
+  enum class hatch {
+    horizontal,
+    vertical,
+    diagonal,      // from the top left to the bottom right
+    anti_diagonal, // from the top right to the bottom left
+    cross,
+    diagonal_cross,
+  };
+
+  /**
+   * Gray levels are the number of white pixels out of the 64 of the tile.
+   */
+  static constexpr int max_gray_level = 64;
+
+private:
+  std::array<uint8_t, 8> m_rows;
+
+public:
+  explicit pattern(const std::array<uint8_t, 8> &rows);
+
+  static pattern solid(bool white);
+
+  /**
+   * Ordered dither of a gray level, with the pixels spread out evenly by
+   * the 8x8 Bayer matrix. Every level has the white pixels of the darker
+   * ones, so that gradients don't shimmer.
+   * @param level 0 for black to max_gray_level for white
+   */
+  static pattern gray(int level);
+
+  /**
+   * One pixel wide black lines on white, 8 pixels apart.
+   */
+  static pattern hatching(hatch h);
+
+  pattern inverted() const;
+
+  /**
+   * Get the pattern anchored to another point of the bitmap instead of its
+   * top left corner.
+   */
+  pattern shifted(int dx, int dy) const;
+
+  /**
+   * Get the byte to fill row y of the bitmap with.
+   */
+  uint8_t row(int y) const;
+
+  bool operator==(const pattern &other) const = default;
+};
+
+inline uint8_t pattern::row(int y) const { return m_rows[y & 7]; }
+
+} // namespace ui
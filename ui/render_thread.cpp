@@ -0,0 +1,45 @@
+#include "render_thread.h"
+
+namespace ui {
+
+render_thread::render_thread(element &root, callback frame_ready)
+    : m_root(root), m_frame_ready(std::move(frame_ready)),
+      m_frames(root.get_bitmap()) {
+  m_thread = std::thread([this]() { m_loop.run(); });
+}
+
+render_thread::~render_thread() {
+  // Stopped from within the loop, so that it can't be stopped before it runs.
+  m_loop.post([this]() { m_loop.stop(); });
+  m_thread.join();
+}
+
+void render_thread::post(callback change) {
+  m_loop.post([this, change = std::move(change)]() {
+    change();
+
+    // Posted from within the loop, it runs after everything posted so far.
+    if (!m_render_posted) {
+      m_render_posted = true;
+      m_loop.post([this]() { render(); });
+    }
+  });
+}
+
+void render_thread::render() {
+  m_render_posted = false;
+
+  if (m_root.render_damage().area() == 0)
+    return;
+
+  // Whole frames are handed over, since the display side may skip some.
+  m_frames.back() = m_root.get_bitmap();
+  m_frames.publish();
+  m_frame_ready();
+}
+
+bool render_thread::take_frame() { return m_frames.update(); }
+
+const bitmap &render_thread::frame() const { return m_frames.front(); }
+
+} // namespace ui
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "element.h"
+
+#include <event_loop.h>
+#include <triple_buffer.h>
+
+#include <functional>
+#include <thread>
+
+namespace ui {
+
+/**
+ * Runs an element tree on a thread of its own.
+ *
+ * Changes of the UI state (e.g. touch events to dispatch) are posted to the
+ * thread, which applies them and renders the damage into the bitmap of the
+ * root element, its back buffer. Rendered frames are handed over to the
+ * display side through a triple buffer, so that input handling, rendering
+ * and uploading of the previous frame to the display all go on at the same
+ * time, and none of them waits for another.
+ *
+ * Once the thread is running, the element tree may only be touched from
+ * within the posted changes.
+ */
+class render_thread {
+public:
+  using callback = std::function<void()>;
+
+private:
+  element &m_root;
+  callback m_frame_ready;
+  triple_buffer<bitmap> m_frames;
+
+  event_loop m_loop;
+  bool m_render_posted = false; // render thread only
+  std::thread m_thread;
+
+  void render();
+
+public:
+  /**
+   * Start the thread; the current bitmap of the root is the first frame.
+   * @param frame_ready called on the render thread every time a new frame
+   * has been published, e.g. to wake up the display side
+   */
+  render_thread(element &root, callback frame_ready);
+  ~render_thread();
+
+  render_thread(const render_thread &) = delete;
+  render_thread &operator=(const render_thread &) = delete;
+
+  /**
+   * Apply a change on the render thread. Changes posted together are
+   * rendered into a single frame. Thread safe.
+   */
+  void post(callback change);
+
+  /**
+   * Take the latest frame, if there's a new one; display side only.
+   * @return false if no frame has been rendered since the last call
+   */
+  bool take_frame();
+
+  /**
+   * Get the frame taken last; display side only.
+   */
+  const bitmap &frame() const;
+};
+
+} // namespace ui
@@ -0,0 +1,58 @@
+#include "span.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace ui {
+
+static void fill_bytes(uint8_t *bytes, int count, uint8_t value) {
+#if defined(__SSE2__)
+  const auto block = _mm_set1_epi8(char(value));
+  for (; count >= 16; count -= 16, bytes += 16)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(bytes), block);
+#elif defined(__ARM_NEON)
+  const auto block = vdupq_n_u8(value);
+  for (; count >= 16; count -= 16, bytes += 16)
+    vst1q_u8(bytes, block);
+#endif
+
+  const uint64_t word = 0x0101010101010101ull * value;
+  for (; count >= 8; count -= 8, bytes += 8)
+    std::memcpy(bytes, &word, sizeof(word));
+
+  for (; count > 0; --count)
+    *bytes++ = value;
+}
+
+static void merge(uint8_t &byte, uint8_t value, uint8_t mask) {
+  byte = (byte & ~mask) | (value & mask);
+}
+
+void fill_span(uint8_t *row, int begin_x, int end_x, uint8_t pattern) {
+  if (begin_x >= end_x)
+    return;
+
+  int first = begin_x >> 3;
+  int last = (end_x - 1) >> 3;
+  const uint8_t first_mask = 0xff >> (begin_x & 7);
+  const uint8_t last_mask = 0xff << (7 - ((end_x - 1) & 7));
+
+  if (first == last) {
+    merge(row[first], pattern, first_mask & last_mask);
+    return;
+  }
+
+  if (first_mask != 0xff)
+    merge(row[first++], pattern, first_mask);
+  if (last_mask != 0xff)
+    merge(row[last--], pattern, last_mask);
+
+  fill_bytes(row + first, last - first + 1, pattern);
+}
+
+} // namespace ui
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ui {
+
+/**
+ * Set the pixels [begin_x, end_x) of a bitmap row to the bits of a byte
+ * repeated along the row, i.e. pixel x gets bit 7 - x % 8 of it; 0x00 and
+ * 0xff fill with black and white. Whole bytes are written at once, only the
+ * bytes at the ends of the span are merged with masks.
+ * @param row first byte of the row
+ */
+void fill_span(uint8_t *row, int begin_x, int end_x, uint8_t pattern);
+
+} // namespace ui
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/**
+ * Lock-free exchange of values between a single producer thread and a single
+ * consumer thread, e.g. of frames between a renderer and a display.
+ *
+ * Neither side ever waits for the other: the producer always has a buffer of
+ * its own to write to, and the consumer always gets the latest published
+ * value; values published in the meantime are skipped.
+ */
+template <typename T> class triple_buffer {
+  // Set in the middle index once a value has been published there, and
+  // cleared once the consumer has taken it.
+  static constexpr unsigned fresh = 4;
+
+  std::array<T, 3> m_buffers;
+  std::atomic<unsigned> m_middle = 1;
+  unsigned m_back = 0;  // producer only
+  unsigned m_front = 2; // consumer only
+
+public:
+  triple_buffer() = default;
+  triple_buffer(const T &initial) : m_buffers{initial, initial, initial} {}
+
+  triple_buffer(const triple_buffer &) = delete;
+  triple_buffer &operator=(const triple_buffer &) = delete;
+
+  /**
+   * Get the buffer to write the next value into; producer only.
+   */
+  T &back() { return m_buffers[m_back]; }
+
+  /**
+   * Hand the back buffer over to the consumer; producer only.
+   */
+  void publish() {
+    m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) &
+             ~fresh;
+  }
+
+  /**
+   * Take the latest published value, if there's any new one; consumer only.
+   * @return false if nothing has been published since the last update
+   */
+  bool update() {
+    if (!(m_middle.load(std::memory_order_relaxed) & fresh))
+      return false;
+
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~fresh;
+    return true;
+  }
+
+  /**
+   * Get the value taken by the last update; consumer only.
+   */
+  const T &front() const { return m_buffers[m_front]; }
+};